@@ -0,0 +1,163 @@
+package bk;
+
+import game.Game;
+import main.collections.FastArrayList;
+import other.AI;
+import other.context.Context;
+import other.state.container.ContainerState;
+import other.move.Move;
+import java.io.BufferedReader;
+import java.io.IOException;
+import java.io.InputStreamReader;
+import java.io.OutputStreamWriter;
+import java.io.Writer;
+import java.net.StandardProtocolFamily;
+import java.net.UnixDomainSocketAddress;
+import java.nio.channels.Channels;
+import java.nio.channels.SocketChannel;
+import java.nio.charset.StandardCharsets;
+import java.util.concurrent.atomic.AtomicInteger;
+
+// variante de RandPlayerLocal qui parle au demon "breakthrough_simple serveur"
+// sur une socket unix au lieu de lancer un processus par coup : toutes les
+// parties en cours partagent les threads du serveur (java 16+ pour les
+// sockets unix). Le serveur est lance au premier besoin s'il ne repond pas.
+public class ServerPlayerLocal extends AI
+{
+	public final static int EMPTY = 0;
+	public final static int BLACK = 1;
+	public final static int WHITE = 2;
+	public final static String local_player_str = "/home/nmicuda/Bureau/L3/IA_JEUX/breakthrough-2026/breakthrough_simple";
+	public final static String socket_str = "/tmp/breakthrough_simple.sock";
+	private final static AtomicInteger next_game = new AtomicInteger(0);
+
+	protected int player = -1; // player_index
+	protected String game_name = null;
+	protected SocketChannel channel = null;
+	protected BufferedReader reader = null;
+	protected Writer writer = null;
+
+	public ServerPlayerLocal()	{
+			this.friendlyName = "ServerPlayerLocal";
+	}
+
+	@Override
+	public Move selectAction
+	(
+		final Game game,
+		final Context context,
+		final double maxSeconds,
+		final int maxIterations,
+		final int maxDepth
+	)
+	{
+		FastArrayList<Move> legalMoves = game.moves(context).moves();
+		int board[] = new int[64];
+		for (final ContainerState containerState : context.state().containerStates()) {
+			for(int i = 0; i < 64; i++) {
+				if(containerState.isEmptyCell(i)) board[i] = EMPTY;
+				if(containerState.whoCell(i) == 2) board[i] = BLACK;
+				if(containerState.whoCell(i) == 1) board[i] = WHITE;
+			}
+		}
+		StringBuilder sb = new StringBuilder();
+		for(int i = 7; i >= 0; i--) {
+			for(int j = 0; j < 8; j++) {
+				if(board[i*8+j] == BLACK) {sb.append("1"); }
+				else if(board[i*8+j] == WHITE) {sb.append("0"); }
+				else { sb.append("."); }
+			}
+		}
+		String turn = "0";
+		if(player==2) turn = "1";
+		// marge pour l'aller-retour et l'attente derriere les autres parties
+		long ms = Math.max(10, (long)(maxSeconds*1000*0.8));
+		String res = "";
+		try {
+			res = request("go "+game_name+" "+sb.toString()+" "+turn+" "+ms);
+		} catch(Exception e) {
+			System.err.println("[info] serveur indisponible : "+e);
+			close();
+		}
+		// "coup <jeu> A2-B3 ms ..." ; sinon "erreur <jeu> <message>"
+		String[] words = res.split(" ");
+		if(words.length >= 3 && words[0].equals("coup") && words[2].length() == 5) {
+			String m = words[2];
+			int pos_i = (m.charAt(1)-'1')*8+(m.charAt(0)-'A');
+			int pos_f = (m.charAt(4)-'1')*8+(m.charAt(3)-'A');
+			for(int i = 0; i < legalMoves.size(); i++) {
+				if(legalMoves.get(i).from() == pos_i && legalMoves.get(i).to() == pos_f) return legalMoves.get(i);
+			}
+		}
+		System.err.println("error "+res);
+		System.out.println(local_player_str+" play random");
+		return legalMoves.get(0);
+	}
+
+	@Override
+	public void initAI(final Game game, final int playerID)
+	{
+		this.player = playerID;
+		this.game_name = "ludii"+next_game.incrementAndGet()+"-"+playerID;
+	}
+
+	@Override
+	public void closeAI()
+	{
+		close();
+	}
+
+	// une ligne de commande, une ligne de reponse (une connexion par joueur)
+	protected synchronized String request(String _line) throws IOException, InterruptedException
+	{
+		if(channel == null) connect();
+		writer.write(_line+"\n");
+		writer.flush();
+		String res = reader.readLine();
+		if(res == null) throw new IOException("connexion fermee");
+		return res.trim();
+	}
+
+	protected void connect() throws IOException, InterruptedException
+	{
+		UnixDomainSocketAddress address = UnixDomainSocketAddress.of(socket_str);
+		for(int attempt = 0; ; attempt++) {
+			try {
+				channel = SocketChannel.open(StandardProtocolFamily.UNIX);
+				channel.connect(address);
+				break;
+			} catch(IOException e) {
+				// open peut echouer avant toute affectation : channel reste null
+				if(channel != null) {
+					try { channel.close(); } catch(IOException c) { e.addSuppressed(c); }
+				}
+				channel = null;
+				if(attempt == 20) throw e;
+				if(attempt == 0) startServerLocal();
+				Thread.sleep(50);
+			}
+		}
+		reader = new BufferedReader(new InputStreamReader(Channels.newInputStream(channel), StandardCharsets.US_ASCII));
+		writer = new OutputStreamWriter(Channels.newOutputStream(channel), StandardCharsets.US_ASCII);
+	}
+
+	protected void close()
+	{
+		try {
+			if(channel != null) channel.close();
+		} catch(IOException e) { System.err.println(e); }
+		channel = null;
+		reader = null;
+		writer = null;
+	}
+
+	// plusieurs joueurs peuvent tenter de le lancer : le second bind echoue
+	// apres le premier et le client se connecte au serveur deja present
+	public static void startServerLocal() throws IOException
+	{
+		ProcessBuilder processBuilder = new ProcessBuilder(local_player_str, "serveur", socket_str);
+		processBuilder.redirectErrorStream(true);
+		processBuilder.redirectOutput(ProcessBuilder.Redirect.DISCARD);
+		processBuilder.start();
+	}
+}
@@ -1,4 +1,4 @@
 rm -f RandPlayerLocal.jar
-javac -cp Ludii-1.3.14.jar RandPlayerLocal.java
-mv RandPlayerLocal.class bk/
-jar cf RandPlayerLocal.jar bk/RandPlayerLocal.class
+javac -cp Ludii-1.3.14.jar RandPlayerLocal.java ServerPlayerLocal.java
+mv RandPlayerLocal.class ServerPlayerLocal.class bk/
+jar cf RandPlayerLocal.jar bk/RandPlayerLocal.class bk/ServerPlayerLocal.class
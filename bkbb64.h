@@ -12,32 +12,171 @@
 #include <climits>
 #include <inttypes.h>
 #include <vector>
+#include "bkbb64_prof.h"
+#include "bkbb64_rng.h"
+#include "bkbb64_notation.h"
+#include "bkbb64_geom.h"
+
+// masques des colonnes et des lignes (bit 0 = A8, bit 63 = H1)
+typedef Geom_t<8, 8> Geom8_t;
+static const uint64_t COL_NOT_A = Geom8_t::NOT_COL_A;    // 0xfefefefefefefefe
+static const uint64_t COL_NOT_H = Geom8_t::NOT_COL_LAST; // 0x7f7f7f7f7f7f7f7f
+static const uint64_t ROW_8 = Geom8_t::ROW_TOP;          // but des blancs
+static const uint64_t ROW_1 = Geom8_t::ROW_BOTTOM;       // but des noirs
+static_assert(COL_NOT_A == 0xfefefefefefefefeULL && COL_NOT_H == 0x7f7f7f7f7f7f7f7fULL &&
+              ROW_8 == 0xffULL && ROW_1 == 0xff00000000000000ULL, "masques 8x8");
+// ligne _row du tableau (0 = rangée 8, 7 = rangée 1)
+static inline
+uint64_t row_mask(int _row) {
+  return 0xffULL<<(8*_row);
+}
 
 struct Move64_t {
   uint64_t pi;
   uint64_t pf;
 
   std::string move_to_str();
+  Move64_t mirror() const;
+  bool operator== (const Move64_t& _o) const { return pi == _o.pi && pf == _o.pf; }
+  bool operator!= (const Move64_t& _o) const { return !(*this == _o); }
 };
 
+// case _sq (0 = A8) en texte "A8"
+static inline
+void sq_to_coord(int _sq, char* _buf) {
+  _buf[0] = char('A'+(_sq & 7));
+  _buf[1] = char('8'-(_sq>>3));
+}
+// case "A8" en indice, -1 si invalide
+static inline
+int coord_to_sq(const char* _s) {
+  int col = _s[0]-'A';
+  int row = '8'-_s[1];
+  if(col < 0 || col > 7 || row < 0 || row > 7) return -1;
+  return row*8+col;
+}
 inline
 std::string pos_to_coord(const uint64_t& pos) {
-  uint64_t where = 0ULL;
-  for(int i = 0; i < 64; i++) {
-    where = (1ULL<<i);
-    if(where == pos) {
-      char buf[3];
-      snprintf(buf,3,"%c%c", 'A'+i%8, '0'+8-(i/8));
-      return std::string(buf);
-    }
-  }
-  return std::string("ERROR");
+  if(pos == 0ULL || (pos & (pos-1)) != 0ULL) return std::string("ERROR");
+  char buf[2];
+  sq_to_coord(__builtin_ctzll(pos), buf);
+  return std::string(buf, 2);
 }
 inline
 std::string Move64_t::move_to_str() {
   return pos_to_coord(pi)+"-"+pos_to_coord(pf);
 }
 
+// symétrie gauche-droite (colonne A <-> H) : inverse les bits de chaque octet
+static inline
+uint64_t mirror64(uint64_t x) {
+  x = ((x>>1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL)<<1);
+  x = ((x>>2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL)<<2);
+  x = ((x>>4) & 0x0f0f0f0f0f0f0f0fULL) | ((x & 0x0f0f0f0f0f0f0f0fULL)<<4);
+  return x;
+}
+inline
+Move64_t Move64_t::mirror() const {
+  Move64_t m;
+  m.pi = mirror64(pi);
+  m.pf = mirror64(pf);
+  return m;
+}
+
+// coup compact sur 16 bits : case de départ (bits 0-5), direction (bits 6-7,
+// 0 = pas de coup), prise (bit 8) et camp (bit 9, 1 = noirs). L'octet bas
+// suffit quand le camp est connu (arbre mcts). Deux coups sont égaux s'ils
+// déplacent le même pion dans la même direction, prise ou non.
+enum { DIR_NONE = 0, DIR_FORWARD = 1, DIR_LEFT = 2, DIR_RIGHT = 3 };
+
+// décalage de la case d'arrivée par direction, mêmes que Board64_t
+static inline
+int dir_delta(int _dir, bool _white) {
+  static const int8_t DELTA[2][4] = {{0, 8, 7, 9}, {0, -8, -9, -7}};
+  return DELTA[_white][_dir];
+}
+
+struct Move16_t {
+  uint16_t v;
+
+  static Move16_t make(int _from, int _dir, bool _white, bool _capture = false) {
+    Move16_t m;
+    m.v = uint16_t(_from | (_dir<<6) | (_capture ? 0x100 : 0) | (_white ? 0 : 0x200));
+    return m;
+  }
+  static Move16_t from_code8(uint8_t _code, bool _white) {
+    Move16_t m;
+    m.v = uint16_t(_code | (_white ? 0 : 0x200));
+    return m;
+  }
+  static Move16_t from_squares(int _from, int _to, bool _capture = false);
+  static Move16_t from_move64(const Move64_t& _m, bool _capture = false) {
+    return from_squares(__builtin_ctzll(_m.pi), __builtin_ctzll(_m.pf), _capture);
+  }
+  static Move16_t from_str(const char* _s);
+
+  bool is_null() const { return (v & 0xc0) == 0; }
+  int from() const { return v & 63; }
+  int dir() const { return (v>>6) & 3; }
+  bool capture() const { return (v & 0x100) != 0; }
+  bool white() const { return (v & 0x200) == 0; }
+  int to() const { return from()+dir_delta(dir(), white()); }
+  uint8_t code8() const { return uint8_t(v); }
+  uint64_t from_mask() const { return 1ULL<<from(); }
+  uint64_t to_mask() const { return 1ULL<<(to() & 63); } // hors plateau si coup invalide
+  Move64_t to_move64() const {
+    Move64_t m;
+    m.pi = is_null() ? 0ULL : from_mask();
+    m.pf = is_null() ? 0ULL : to_mask();
+    return m;
+  }
+  Move16_t mirror() const;
+  std::string to_str() const;
+  bool operator== (const Move16_t& _o) const { return ((v ^ _o.v) & 0x2ff) == 0; }
+  bool operator!= (const Move16_t& _o) const { return !(*this == _o); }
+};
+
+static const Move16_t MOVE16_NONE = {0};
+
+// le camp se déduit du sens du déplacement ; MOVE16_NONE si ce n'est pas un pas de pion
+inline
+Move16_t Move16_t::from_squares(int _from, int _to, bool _capture) {
+  bool white = _to < _from;
+  int dc = (_to & 7)-(_from & 7);
+  int dr = (_to>>3)-(_from>>3);
+  if(dr != (white ? -1 : 1) || dc < -1 || dc > 1) return MOVE16_NONE;
+  // gauche = vers la colonne A pour les deux camps, comme Board64_t
+  int dir = dc == 0 ? DIR_FORWARD : (dc < 0 ? DIR_LEFT : DIR_RIGHT);
+  return make(_from, dir, white, _capture);
+}
+// "A2-B3" ; MOVE16_NONE si le texte n'est pas un pas de pion
+inline
+Move16_t Move16_t::from_str(const char* _s) {
+  if(strlen(_s) < 5 || _s[2] != '-') return MOVE16_NONE;
+  int from = coord_to_sq(_s);
+  int to = coord_to_sq(_s+3);
+  if(from < 0 || to < 0) return MOVE16_NONE;
+  return from_squares(from, to);
+}
+// symétrie gauche-droite : la colonne est inversée, gauche et droite échangées
+inline
+Move16_t Move16_t::mirror() const {
+  static const uint8_t MIRROR_DIR[4] = {DIR_NONE, DIR_FORWARD, DIR_RIGHT, DIR_LEFT};
+  Move16_t m;
+  m.v = uint16_t((v & 0x338) | (7-(v & 7)) | (MIRROR_DIR[dir()]<<6));
+  if(is_null()) m.v = v;
+  return m;
+}
+inline
+std::string Move16_t::to_str() const {
+  if(is_null()) return std::string("ERROR");
+  char buf[5];
+  sq_to_coord(from(), buf);
+  buf[2] = '-';
+  sq_to_coord(to(), buf+3);
+  return std::string(buf, 5);
+}
+
 struct Lfr_t { 
   uint64_t left;
   uint64_t forward;
@@ -47,9 +186,10 @@ struct Lfr_t {
   std::vector<Move64_t> get_white_moves();
   std::vector<Move64_t> get_black_moves();
   std::vector<Move64_t> get_moves(bool _white);
-  Move64_t get_nth_white_move(uint32_t _move_id);
-  Move64_t get_nth_black_move(uint32_t _move_id);
-  Move64_t get_nth_move(uint32_t _move_id, bool _white);
+  uint32_t nb_moves() const;
+  Move64_t get_nth_white_move(uint32_t _move_id) const;
+  Move64_t get_nth_black_move(uint32_t _move_id) const;
+  Move64_t get_nth_move(uint32_t _move_id, bool _white) const;
 };
 Lfr_t::Lfr_t(uint64_t _l, uint64_t _f, uint64_t _r) {
   left = _l;
@@ -192,7 +332,11 @@ std::vector<Move64_t> Lfr_t::get_moves(bool _white) {
   else return get_black_moves();
 }
 inline
-Move64_t Lfr_t::get_nth_white_move(uint32_t _move_id) {
+uint32_t Lfr_t::nb_moves() const {
+  return uint32_t(count64(left)+count64(forward)+count64(right));
+}
+inline
+Move64_t Lfr_t::get_nth_white_move(uint32_t _move_id) const {
   uint64_t nb_wl = count64(left);
   uint64_t nb_wf = count64(forward);
   Move64_t ret;
@@ -213,7 +357,7 @@ Move64_t Lfr_t::get_nth_white_move(uint32_t _move_id) {
   return ret;
 }
 inline
-Move64_t Lfr_t::get_nth_black_move(uint32_t _move_id) {
+Move64_t Lfr_t::get_nth_black_move(uint32_t _move_id) const {
   uint64_t nb_wl = count64(left);
   uint64_t nb_wf = count64(forward);
   Move64_t ret;
@@ -234,7 +378,7 @@ Move64_t Lfr_t::get_nth_black_move(uint32_t _move_id) {
   return ret;
 }
 inline
-Move64_t Lfr_t::get_nth_move(uint32_t _move_id, bool _white) {
+Move64_t Lfr_t::get_nth_move(uint32_t _move_id, bool _white) const {
   if(_white) return get_nth_white_move(_move_id);
   else return get_nth_black_move(_move_id);
 }
@@ -246,11 +390,21 @@ struct Board64_t {
 
   Board64_t();
   Board64_t(const std::string& strboard);
+  int parse(const char* _s, size_t _len, int* _alphabet = NULL);
+  std::string to_string(int _alphabet = ALPHABET_SYMBOLS) const;
   bool operator== (const Board64_t&) const;
+  uint64_t hash(bool _white) const;
+  Board64_t mirror() const;
+  bool is_mirror_smaller() const;
+  uint64_t canonical_hash(bool _white, bool* _mirrored) const;
+  bool is_legal(const Move64_t& move, bool _white) const;
   int eval(const bool _white) const;
   void apply_white_move(const Move64_t& move);
   void apply_black_move(const Move64_t& move);
   void apply_move(const Move64_t& move, bool _white);
+  void apply_move(const Move16_t& move);
+  bool is_legal(const Move16_t& move) const;
+  Move16_t move16(int _from, int _dir, bool _white) const;
   void print_board(FILE* out) const;
   void print_moves(const bool _white) const;
   uint64_t white_forward() const;
@@ -263,6 +417,7 @@ struct Board64_t {
   uint32_t black_win() const;
 
   uint64_t forward(bool _white) const;
+  Lfr_t lfr(bool _white) const;
   uint64_t left(bool _white) const;
   uint64_t right(bool _white) const;
   uint32_t win(bool _white) const;
@@ -280,23 +435,36 @@ struct Board64_t {
 
   void seq_playout(bool _white);
 
+  // mêmes tirages avec un générateur externe (Rng64_t, RngBuffer_t, ...)
+  template<class Rng> Move64_t get_rand_move(const Lfr_t& lfr, bool _white, Rng& _rng) const;
+  template<class Rng> bool seq_playout(bool _white, Rng& _rng);
+  template<class Rng> bool seq_playout_record(bool _white, Rng& _rng, uint64_t* _to);
 };
 
 inline
 Board64_t::Board64_t() {
-  black = 0x000000000000ffff;
-  white = 0xffff000000000000;
+  black = Geom8_t::BLACK_START;
+  white = Geom8_t::WHITE_START;
   seed = 1ULL;
 }
+// plateau vide si la chaîne est invalide (utiliser parse() pour l'erreur)
 inline
 Board64_t::Board64_t(const std::string& strboard) {
   black = 0ULL;
   white = 0ULL;
-  for(int i = 0; i < (int)strboard.size(); i++) {
-    if(strboard[i] == '@') black += (1ULL<<i);
-    if(strboard[i] == 'O') white += (1ULL<<i);
-  }
   seed = 1ULL;
+  parse(strboard.data(), strboard.size());
+}
+// BOARD_PARSE_OK ou le code d'erreur de parse_board64 (plateau inchangé)
+inline
+int Board64_t::parse(const char* _s, size_t _len, int* _alphabet) {
+  return parse_board64(_s, _len, white, black, _alphabet);
+}
+inline
+std::string Board64_t::to_string(int _alphabet) const {
+  char buf[64];
+  format_board64(white, black, _alphabet, buf);
+  return std::string(buf, 64);
 }
 inline
 bool Board64_t::operator== (const Board64_t& _o) const {
@@ -304,6 +472,62 @@ bool Board64_t::operator== (const Board64_t& _o) const {
   return false;
 }
 
+// finaliseur de splitmix64
+static inline
+uint64_t mix64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+// clé de la position avec le trait (pour les tables de transposition)
+inline
+uint64_t Board64_t::hash(bool _white) const {
+  return mix64(mix64(white) ^ black ^ (_white ? 0x9e3779b97f4a7c15ULL : 0ULL));
+}
+inline
+Board64_t Board64_t::mirror() const {
+  Board64_t b = *this;
+  b.white = mirror64(white);
+  b.black = mirror64(black);
+  return b;
+}
+// true si la position symétrique est la représentante canonique
+inline
+bool Board64_t::is_mirror_smaller() const {
+  uint64_t mw = mirror64(white);
+  if(mw != white) return mw < white;
+  return mirror64(black) < black;
+}
+// clé identique pour une position et sa symétrique ; *_mirrored indique
+// si la clé est celle de la symétrique (les coups stockés avec cette clé
+// sont alors à symétriser avec Move64_t::mirror)
+inline
+uint64_t Board64_t::canonical_hash(bool _white, bool* _mirrored) const {
+  bool m = is_mirror_smaller();
+  if(_mirrored) *_mirrored = m;
+  return m ? mirror().hash(_white) : hash(_white);
+}
+// vérifie qu'un coup (par exemple lu dans une table) est jouable ici
+inline
+bool Board64_t::is_legal(const Move64_t& move, bool _white) const {
+  if(move.pi == 0ULL || (move.pi & (move.pi-1)) != 0ULL) return false;
+  if(_white) {
+    if((move.pi & white) == 0ULL) return false;
+    if(move.pf == (move.pi>>8)) return (white_forward() & move.pf) != 0ULL;
+    if(move.pf == ((move.pi & COL_NOT_A)>>9)) return (move.pf & white) == 0ULL;
+    if(move.pf == ((move.pi & COL_NOT_H)>>7)) return (move.pf & white) == 0ULL;
+  } else {
+    if((move.pi & black) == 0ULL) return false;
+    if(move.pf == (move.pi<<8)) return (black_forward() & move.pf) != 0ULL;
+    if(move.pf == ((move.pi & COL_NOT_A)<<7)) return (move.pf & black) == 0ULL;
+    if(move.pf == ((move.pi & COL_NOT_H)<<9)) return (move.pf & black) == 0ULL;
+  }
+  return false;
+}
+
 inline
 int Board64_t::eval(const bool _white) const { // + lignes des pions et - lignes de pions adverses
   int score = 0;
@@ -346,6 +570,31 @@ void Board64_t::apply_move(const Move64_t& move, bool _white) {
   else apply_black_move(move);
 }
 inline
+void Board64_t::apply_move(const Move16_t& move) {
+  uint64_t pi = move.from_mask();
+  uint64_t pf = move.to_mask();
+  if(move.white()) {
+    white = (white^pi)|pf;
+    black &= ~pf;
+  } else {
+    black = (black^pi)|pf;
+    white &= ~pf;
+  }
+}
+inline
+bool Board64_t::is_legal(const Move16_t& move) const {
+  if(move.is_null()) return false;
+  Move64_t m = move.to_move64();
+  return is_legal(m, move.white()) && ((m.pf & (move.white() ? black : white)) != 0ULL) == move.capture();
+}
+// coup de _from dans la direction _dir avec le drapeau de prise de cette position
+inline
+Move16_t Board64_t::move16(int _from, int _dir, bool _white) const {
+  int to = _from+dir_delta(_dir, _white);
+  bool capture = ((_white ? black : white)>>to) & 1ULL;
+  return Move16_t::make(_from, _dir, _white, capture);
+}
+inline
 void Board64_t::print_board(FILE* out=stdout) const {
   std::bitset<64> bbs(black);
   std::bitset<64> wbs(white);
@@ -387,36 +636,36 @@ void Board64_t::print_moves(const bool _white) const {
 inline
 uint64_t Board64_t::white_forward() const {
   uint64_t empty = ~(white | black);
-  return (white >> 8) & empty;
+  return (white >> Geom8_t::FORWARD) & empty;
 }
 inline
 uint64_t Board64_t::white_left() const {
-  return ((white & 0xfefefefefefefefe)>>9)&~white;
+  return ((white & COL_NOT_A)>>Geom8_t::DIAG_A_WHITE)&~white;
 }
 inline
 uint64_t Board64_t::white_right() const {
-  return ((white & 0x7f7f7f7f7f7f7f7f)>>7)&~white;
+  return ((white & COL_NOT_H)>>Geom8_t::DIAG_H_WHITE)&~white;
 }
 inline
 uint32_t Board64_t::white_win() const {
-  return (black==0ULL) | ((white&0x00000000000000ff)!=0ULL);
+  return (black==0ULL) | ((white&ROW_8)!=0ULL);
 }
 inline
 uint64_t Board64_t::black_forward() const {
   uint64_t empty =~(white | black);
-  return (black << 8) & empty;
+  return (black << Geom8_t::FORWARD) & empty;
 }
 inline
 uint64_t Board64_t::black_left() const {
-  return ((black & 0xfefefefefefefefe)<<7)&~black;
+  return ((black & COL_NOT_A)<<Geom8_t::DIAG_A_BLACK)&~black;
 }
 inline
 uint64_t Board64_t::black_right() const {
-  return ((black & 0x7f7f7f7f7f7f7f7f)<<9)&~black;
+  return ((black & COL_NOT_H)<<Geom8_t::DIAG_H_BLACK)&~black;
 }
 inline
 uint32_t Board64_t::black_win() const {
-  return (white==0ULL) |((black&0xff00000000000000)!=0ULL);
+  return (white==0ULL) |((black&ROW_1)!=0ULL);
 }
 inline
 uint64_t Board64_t::forward(bool _white) const {
@@ -424,6 +673,10 @@ uint64_t Board64_t::forward(bool _white) const {
   else return black_forward();
 }
 inline
+Lfr_t Board64_t::lfr(bool _white) const {
+  return Lfr_t(left(_white), forward(_white), right(_white));
+}
+inline
 uint64_t Board64_t::left(bool _white) const {
   if(_white) return white_left();
   else return black_left();
@@ -502,14 +755,25 @@ uint64_t rand_xorshift64(uint64_t rng_state) {
   rng_state ^= (rng_state << 30);    
   return rng_state;
 }
+// tirage sans biais dans [0, _n) avec l'état 32 bits de Board64_t::seed.
+// La réduction garde les bits de poids fort de x*_n : une graine petite
+// (1 par défaut) reste petite après un pas de xorshift32 et donnerait
+// toujours le coup 0 ; la sortie passe donc par le finaliseur de splitmix64
+static inline
+uint32_t xorshift_bounded(uint32_t& _state, uint32_t _n) {
+  uint32_t r;
+  do {
+    _state = rand_xorshift(_state);
+  } while(!lemire_reduce(uint32_t(mix64(_state)>>32), _n, r));
+  return r;
+}
 
 inline
 Move64_t Board64_t::get_rand_white_move(const Lfr_t& lfr) { 
   uint64_t nb_wl = count64(lfr.left);
   uint64_t nb_wf = count64(lfr.forward);
   uint64_t nb_wr = count64(lfr.right);
-  seed = rand_xorshift(seed);
-  uint32_t move_id = seed%uint32_t(nb_wf+nb_wl+nb_wr); 
+  uint32_t move_id = xorshift_bounded(seed, uint32_t(nb_wf+nb_wl+nb_wr));
   Move64_t ret;
   if(move_id < nb_wf) {
     ret.pf = select_move(lfr.forward, move_id); 
@@ -543,8 +807,7 @@ Move64_t Board64_t::get_rand_black_move(const Lfr_t& lfr) {
   uint64_t nb_wl = count64(lfr.left);
   uint64_t nb_wf = count64(lfr.forward);
   uint64_t nb_wr = count64(lfr.right);
-  seed = rand_xorshift(seed);
-  uint32_t move_id = seed%uint32_t(nb_wl+nb_wf+nb_wr); 
+  uint32_t move_id = xorshift_bounded(seed, uint32_t(nb_wl+nb_wf+nb_wr));
   Move64_t ret;
   if(move_id < nb_wf) {
     ret.pf = select_move(lfr.forward, move_id);  
@@ -590,6 +853,7 @@ void Board64_t::rand_move(bool _white) {
 }
 inline 
 void Board64_t::seq_playout(bool _white) {
+  BK_PROF_COUNT(PROF_PLAYOUTS);
   while(1) {
     if(_white) {      
       rand_white_move();
@@ -601,21 +865,77 @@ void Board64_t::seq_playout(bool _white) {
     _white = ! _white;
   }
 }
+template<class Rng>
+inline
+Move64_t Board64_t::get_rand_move(const Lfr_t& lfr, bool _white, Rng& _rng) const {
+  return lfr.get_nth_move(_rng.bounded(lfr.nb_moves()), _white);
+}
+// true si les blancs gagnent ; un camp sans coup perd
+template<class Rng>
+inline
+bool Board64_t::seq_playout(bool _white, Rng& _rng) {
+  BK_PROF_COUNT(PROF_PLAYOUTS);
+  while(1) {
+    Lfr_t l = lfr(_white);
+    uint32_t nb = l.nb_moves();
+    if(nb == 0) return !_white;
+    if(_white) {
+      apply_white_move(l.get_nth_move(_rng.bounded(nb), true));
+      if(white_win()) return true;
+    } else {
+      apply_black_move(l.get_nth_move(_rng.bounded(nb), false));
+      if(black_win()) return false;
+    }
+    _white = ! _white;
+  }
+}
+// playout qui note les coups de chaque camp pour les statistiques amaf :
+// un masque des cases d'arrivée par camp et par direction (_to[3*blancs+dir-1],
+// la case et la direction donnent le coup) ; un camp sans coup perd.
+// true si les blancs gagnent
+template<class Rng>
+inline
+bool Board64_t::seq_playout_record(bool _white, Rng& _rng, uint64_t* _to) {
+  BK_PROF_COUNT(PROF_PLAYOUTS);
+  while(1) {
+    Lfr_t l = lfr(_white);
+    uint32_t nb = l.nb_moves();
+    if(nb == 0) return !_white;
+    Move64_t m = l.get_nth_move(_rng.bounded(nb), _white);
+    int shift = __builtin_ctzll(m.pi)-__builtin_ctzll(m.pf); // 8, 9 ou 7 pour les blancs
+    if(!_white) shift = -shift;
+    int dir = shift == 8 ? DIR_FORWARD : ((shift == 9) == _white ? DIR_LEFT : DIR_RIGHT);
+    _to[3*_white+dir-1] |= m.pf;
+    if(_white) {
+      apply_white_move(m);
+      if(white_win()) return true;
+    } else {
+      apply_black_move(m);
+      if(black_win()) return false;
+    }
+    _white = !_white;
+  }
+}
 
 // g++ -std=c++11 -Wall -O3
 // Apple M1 Max : 3.119.200.000 per second
 // AMD EPYC 7643 48-Core Base Clock 2.3GHz : 1.632.510.000 per second
+// (ces chiffres datent d'avant que le résultat des playouts soit consommé :
+// sans cela le compilateur peut supprimer la boucle de jeu)
+// un seul flux Rng64_t, sans réensemencer à chaque playout
 void print_playout_perf_per_sec(bool _print) {
+  BK_PROF_SCOPE(PHASE_PLAYOUT);
   Board64_t board;
   Board64_t turn0_board;
+  Rng64_t rng(1ULL);
   auto begin = std::chrono::steady_clock::now();
   uint64_t nb_playout = 0ULL;
   uint64_t nb_playout_eval_clock = 0ULL;  
-  uint32_t seed = 1;
+  uint64_t nb_white_wins = 0ULL;
   while(1) {
     board = turn0_board;
-    board.seed = seed;
-    board.seq_playout(true);
+    board.seq_playout(true, rng);
+    nb_white_wins += board.white_win() ? 1ULL : 0ULL;
     nb_playout = nb_playout+1ULL;
     nb_playout_eval_clock = nb_playout_eval_clock+1ULL;
     if(nb_playout_eval_clock == 10000ULL) {
@@ -624,9 +944,9 @@ void print_playout_perf_per_sec(bool _print) {
       if(elapsed > 1E9) break;
       nb_playout_eval_clock = 0ULL;
     } 
-    seed = seed+1;
   }
-  if(_print) fprintf(stderr, "nb_playout %" PRIu64 " per second\n", nb_playout);
+  if(_print) fprintf(stderr, "nb_playout %" PRIu64 " per second (white wins %.3f)\n",
+                     nb_playout, double(nb_white_wins)/double(nb_playout));
 }
 
 #endif /* BKBB64_H */
\ No newline at end of file
@@ -0,0 +1,119 @@
+// livre d'ouvertures : fichier binaire trié par clé de position, lu par mmap
+// format : BookHeader_t puis nb_entries BookEntry_t triées par key croissante
+#ifndef BKBB64_BOOK_H
+#define BKBB64_BOOK_H
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bkbb64.h"
+
+static const char BOOK_MAGIC[8] = {'B','K','B','O','O','K','1','\0'};
+
+struct BookHeader_t {
+  char magic[8];
+  uint64_t nb_entries;
+  uint32_t mirror;    // clés canoniques (Board64_t::canonical_hash)
+  uint32_t plies;     // profondeur d'ouverture couverte
+};
+
+// 16 octets : coup dans l'orientation de la clé
+struct BookEntry_t {
+  uint64_t key;
+  uint8_t from;
+  uint8_t to;
+  int16_t depth;
+  int32_t score;
+};
+
+static inline
+bool book_entry_less(const BookEntry_t& _a, const BookEntry_t& _b) {
+  return _a.key < _b.key;
+}
+
+// lecture du livre projeté en mémoire, aucune allocation à la recherche
+struct Book_t {
+  const BookHeader_t* header;
+  const BookEntry_t* entries;
+  size_t map_size;
+
+  Book_t() : header(NULL), entries(NULL), map_size(0) {}
+  ~Book_t() { close(); }
+  bool open(const char* _path);
+  void close();
+  bool find(const Board64_t& _b, bool _white, Move16_t& _m, BookEntry_t* _e = NULL) const;
+};
+
+inline
+bool Book_t::open(const char* _path) {
+  close();
+  int fd = ::open(_path, O_RDONLY);
+  if(fd < 0) return false;
+  struct stat st;
+  if(fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(BookHeader_t)) {
+    ::close(fd);
+    return false;
+  }
+  void* p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(p == MAP_FAILED) return false;
+  map_size = st.st_size;
+  header = (const BookHeader_t*)p;
+  entries = (const BookEntry_t*)(header+1);
+  if(memcmp(header->magic, BOOK_MAGIC, 8) != 0 ||
+     sizeof(BookHeader_t)+header->nb_entries*sizeof(BookEntry_t) > map_size) {
+    close();
+    return false;
+  }
+  return true;
+}
+inline
+void Book_t::close() {
+  if(header) munmap((void*)header, map_size);
+  header = NULL;
+  entries = NULL;
+  map_size = 0;
+}
+// recherche dichotomique, le coup est remis dans l'orientation de _b
+inline
+bool Book_t::find(const Board64_t& _b, bool _white, Move16_t& _m, BookEntry_t* _e) const {
+  if(!header) return false;
+  bool mirrored = false;
+  uint64_t key = header->mirror ? _b.canonical_hash(_white, &mirrored) : _b.hash(_white);
+  size_t lo = 0;
+  size_t hi = header->nb_entries;
+  while(lo < hi) {
+    size_t mid = lo+(hi-lo)/2;
+    if(entries[mid].key < key) lo = mid+1;
+    else hi = mid;
+  }
+  if(lo == header->nb_entries || entries[lo].key != key) return false;
+  const BookEntry_t& e = entries[lo];
+  _m = Move16_t::from_squares(e.from, e.to);
+  if(mirrored) _m = _m.mirror();
+  if(_e) *_e = e;
+  if(_m.is_null() || _m.white() != _white) return false;
+  _m = _b.move16(_m.from(), _m.dir(), _white); // drapeau de prise de _b
+  return _b.is_legal(_m);
+}
+
+// écrit les entrées (déjà triées) ; renvoie false en cas d'erreur
+inline
+bool book_write(const char* _path, const BookEntry_t* _entries, uint64_t _nb, bool _mirror, int _plies) {
+  FILE* f = fopen(_path, "wb");
+  if(!f) return false;
+  BookHeader_t h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, BOOK_MAGIC, 8);
+  h.nb_entries = _nb;
+  h.mirror = _mirror ? 1 : 0;
+  h.plies = _plies;
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+            (_nb == 0 || fwrite(_entries, sizeof(BookEntry_t), _nb, f) == _nb);
+  return fclose(f) == 0 && ok;
+}
+
+#endif /* BKBB64_BOOK_H */
@@ -0,0 +1,153 @@
+// cache de recherche persistant : table de transposition dans un fichier
+// projeté en mémoire (MAP_SHARED), partagée entre processus successifs ou
+// simultanés. Pas de verrou sur les entrées : chacune stocke key^data et data, une
+// écriture concurrente déchirée est simplement vue comme une absence.
+#ifndef BKBB64_CACHE_H
+#define BKBB64_CACHE_H
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bkbb64.h"
+
+static const char DISK_CACHE_MAGIC[8] = {'B','K','C','A','C','H','E','1'};
+
+struct DiskCacheHeader_t {
+  char magic[8];
+  uint64_t nb_entries; // puissance de 2
+};
+
+struct DiskCacheEntry_t {
+  uint64_t check; // key ^ data
+  uint64_t data;  // score:32 depth:8 flag:2 from:6 to:6 prise:1
+};
+
+struct DiskCacheData_t {
+  int32_t score;
+  int depth;
+  int flag;
+  Move16_t move;
+};
+
+static inline
+uint64_t disk_cache_pack(const DiskCacheData_t& _d) {
+  uint64_t from = _d.move.is_null() ? 0ULL : uint64_t(_d.move.from());
+  uint64_t to = _d.move.is_null() ? 0ULL : uint64_t(_d.move.to());
+  return uint64_t(uint32_t(_d.score)) | (uint64_t(_d.depth & 0xff)<<32) |
+         (uint64_t(_d.flag & 3)<<40) | (from<<42) | (to<<48) | (uint64_t(_d.move.capture())<<54);
+}
+static inline
+DiskCacheData_t disk_cache_unpack(uint64_t _data) {
+  DiskCacheData_t d;
+  d.score = int32_t(uint32_t(_data));
+  d.depth = int((_data>>32) & 0xff);
+  d.flag = int((_data>>40) & 3);
+  d.move = Move16_t::from_squares(int((_data>>42) & 63), int((_data>>48) & 63), (_data>>54) & 1);
+  return d;
+}
+
+struct DiskCache_t {
+  DiskCacheHeader_t* header;
+  DiskCacheEntry_t* entries;
+  uint64_t mask;
+  size_t map_size;
+  int min_depth;  // seules les recherches assez profondes valent un accès
+  std::atomic<uint64_t> probes; // partagés entre les threads de book_builder
+  std::atomic<uint64_t> hits;
+  std::atomic<uint64_t> stores;
+
+  DiskCache_t() : header(NULL), entries(NULL), mask(0), map_size(0), min_depth(4),
+                  probes(0), hits(0), stores(0) {}
+  ~DiskCache_t() { close(); }
+  bool open(const char* _path, size_t _mem_bytes);
+  void close();
+  bool probe(uint64_t _key, DiskCacheData_t& _d);
+  void store(uint64_t _key, const DiskCacheData_t& _d);
+};
+
+// ouvre le fichier, ou le crée avec _mem_bytes d'entrées s'il n'existe pas ;
+// un fichier existant garde sa taille. La création (taille puis en-tête) se
+// fait sous flock : deux processus qui ouvrent ensemble un cache absent ne
+// l'initialisent qu'une fois, le second voit l'en-tête écrit par le premier
+inline
+bool DiskCache_t::open(const char* _path, size_t _mem_bytes) {
+  close();
+  int fd = ::open(_path, O_RDWR | O_CREAT, 0644);
+  if(fd < 0) return false;
+  struct stat st;
+  if(flock(fd, LOCK_EX) != 0 || fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  uint64_t nb = 1;
+  while(nb*2*sizeof(DiskCacheEntry_t) <= _mem_bytes) nb *= 2;
+  size_t size = sizeof(DiskCacheHeader_t)+nb*sizeof(DiskCacheEntry_t);
+  bool fresh = size_t(st.st_size) < sizeof(DiskCacheHeader_t);
+  if(fresh) {
+    // le fichier est étendu par des zéros : entrées vides (check == data == 0)
+    if(ftruncate(fd, size) != 0) {
+      ::close(fd);
+      return false;
+    }
+  } else {
+    size = st.st_size;
+  }
+  void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(p == MAP_FAILED) {
+    ::close(fd);
+    return false;
+  }
+  header = (DiskCacheHeader_t*)p;
+  entries = (DiskCacheEntry_t*)(header+1);
+  map_size = size;
+  if(fresh) {
+    header->nb_entries = nb;
+    memcpy(header->magic, DISK_CACHE_MAGIC, 8);
+  }
+  ::close(fd); // libère le verrou, l'en-tête est en place
+  nb = header->nb_entries;
+  if(memcmp(header->magic, DISK_CACHE_MAGIC, 8) != 0 || nb == 0 || (nb & (nb-1)) != 0 ||
+     sizeof(DiskCacheHeader_t)+nb*sizeof(DiskCacheEntry_t) > map_size) {
+    close();
+    return false;
+  }
+  mask = nb-1;
+  return true;
+}
+inline
+void DiskCache_t::close() {
+  if(header) munmap(header, map_size);
+  header = NULL;
+  entries = NULL;
+  map_size = 0;
+}
+inline
+bool DiskCache_t::probe(uint64_t _key, DiskCacheData_t& _d) {
+  DiskCacheEntry_t* e = &entries[_key & mask];
+  uint64_t check = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+  uint64_t data = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+  probes.fetch_add(1, std::memory_order_relaxed);
+  if((check ^ data) != _key || data == 0ULL) return false;
+  hits.fetch_add(1, std::memory_order_relaxed);
+  _d = disk_cache_unpack(data);
+  return true;
+}
+// remplace une autre position, ou la même si on est au moins aussi profond
+inline
+void DiskCache_t::store(uint64_t _key, const DiskCacheData_t& _d) {
+  DiskCacheEntry_t* e = &entries[_key & mask];
+  uint64_t check = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+  uint64_t data = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+  if((check ^ data) == _key && int((data>>32) & 0xff) > _d.depth) return;
+  uint64_t nd = disk_cache_pack(_d);
+  __atomic_store_n(&e->data, nd, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->check, _key ^ nd, __ATOMIC_RELAXED);
+  stores.fetch_add(1, std::memory_order_relaxed);
+}
+
+#endif /* BKBB64_CACHE_H */
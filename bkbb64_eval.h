@@ -0,0 +1,96 @@
+// évaluation par structure de pions : la plupart des termes ne dépendent que
+// des pions d'un camp (matériel et avancée comme eval_bb, chaînes de
+// soutien, pions côte à côte, pions bloqués par un pion ami, centre, garde
+// de la ligne de départ). Entre deux noeuds frères un seul camp a bougé le
+// plus souvent (l'autre seulement sur une prise) : ce score par camp est
+// gardé dans un petit cache indexé par le bitboard du camp, propre à chaque
+// recherche (un thread par Search64_t, donc ni verrou ni atomique). Une
+// évaluation complète est deux sondes plus les termes d'interaction (pions
+// attaqués et non défendus).
+#ifndef BKBB64_EVAL_H
+#define BKBB64_EVAL_H
+
+#include <cstring>
+#include "bkbb64.h"
+#include "bkbb64_prof.h"
+#include "bkbb64_threat.h"
+
+// poids réglés en match contre eval_bb (search_bench) : un soutien positif
+// fige les chaînes et perd nettement, la garde de la ligne de départ et les
+// pions en prise font l'essentiel du gain
+static const int EVAL_SUPPORT = -2;  // pion défendu par un pion ami
+static const int EVAL_PHALANX = 2;   // pion ami à côté sur la même ligne
+static const int EVAL_JAM = -4;      // pion ami juste devant
+static const int EVAL_CENTRE = 2;    // colonnes C à F
+static const int EVAL_HOME = 20;     // pion resté sur la ligne de départ
+static const int EVAL_HANGING = -30; // pion attaqué et non défendu
+static const uint64_t COL_C_TO_F = 0x3c3c3c3c3c3c3c3cULL;
+
+// termes qui ne dépendent que des pions _p du camp _white, de son point de vue
+inline
+int pawn_structure(uint64_t _p, bool _white) {
+  int score = 0;
+  for(int r = 0; r < 8; r++)
+    score += int(count64(_p & row_mask(r)))*(100+10*(_white ? 7-r : r));
+  uint64_t ahead = _white ? _p<<8 : _p>>8; // case devant un pion ami
+  uint64_t side = ((_p & COL_NOT_A)>>1) | ((_p & COL_NOT_H)<<1);
+  score += EVAL_SUPPORT*int(count64(_p & pawn_attacks(_p, _white)));
+  score += EVAL_PHALANX*int(count64(_p & side));
+  score += EVAL_JAM*int(count64(_p & ahead));
+  score += EVAL_CENTRE*int(count64(_p & COL_C_TO_F));
+  score += EVAL_HOME*int(count64(_p & (_white ? ROW_1 : ROW_8)));
+  return score;
+}
+
+// termes qui dépendent des deux camps, du point de vue du camp _white (pions _p)
+static inline
+int pawn_interaction(uint64_t _p, uint64_t _opp, bool _white) {
+  uint64_t hanging = _p & pawn_attacks(_opp, !_white) & ~pawn_attacks(_p, _white);
+  return EVAL_HANGING*int(count64(hanging));
+}
+
+struct PawnEntry64_t {
+  uint64_t pawns;
+  int32_t score;
+  int32_t pad;
+};
+
+// une table par camp, correspondance directe ; 2 x 4096 entrées (128 Ko)
+// tiennent dans le cache L2
+struct PawnCache64_t {
+  static const int LOG2_SIZE = 12;
+  PawnEntry64_t table[2][1<<LOG2_SIZE];
+
+  PawnCache64_t() { clear(); }
+  // pions == 0 : le score d'un camp sans pion est bien 0
+  void clear() { memset(table, 0, sizeof(table)); }
+  int probe(uint64_t _p, bool _white, uint64_t& _hits) {
+    PawnEntry64_t& e = table[_white][mix64(_p) & ((1<<LOG2_SIZE)-1)];
+    if(e.pawns == _p) {
+      _hits++;
+      return e.score;
+    }
+    e.pawns = _p;
+    e.score = pawn_structure(_p, _white);
+    return e.score;
+  }
+};
+
+// score du point de vue de _white : deux sondes et les interactions
+inline
+int eval_pawns(const Board64_t& _b, bool _white, PawnCache64_t& _cache, uint64_t& _hits) {
+  BK_PROF_COUNT(PROF_EVALS);
+  int score = _cache.probe(_b.white, true, _hits)-_cache.probe(_b.black, false, _hits)+
+              pawn_interaction(_b.white, _b.black, true)-pawn_interaction(_b.black, _b.white, false);
+  return _white ? score : -score;
+}
+// même score sans cache (search_bench : gain du cache)
+inline
+int eval_pawns_full(const Board64_t& _b, bool _white) {
+  BK_PROF_COUNT(PROF_EVALS);
+  int score = pawn_structure(_b.white, true)-pawn_structure(_b.black, false)+
+              pawn_interaction(_b.white, _b.black, true)-pawn_interaction(_b.black, _b.white, false);
+  return _white ? score : -score;
+}
+
+#endif /* BKBB64_EVAL_H */
@@ -0,0 +1,151 @@
+// monte carlo à plat avec élimination par moitiés (sequential halving) pour
+// un coup unique à faible latence : pas d'arbre, seulement deux compteurs par
+// coup de la racine. Le temps est découpé en ceil(log2(n)) manches égales ;
+// à chaque manche les coups restants reçoivent des playouts à tour de rôle
+// (Board64_t::seq_playout), puis la moitié la moins bonne est écartée : les
+// survivants reçoivent deux fois plus de playouts à la manche suivante.
+// Les threads d'une manche se partagent le tourniquet par un compteur atomique.
+#ifndef BKBB64_FLAT_H
+#define BKBB64_FLAT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "bkbb64.h"
+#include "bkbb64_mem.h"
+
+static const int FLAT_MAX_MOVES = 64;
+
+struct FlatResult_t {
+  Move16_t move;
+  double win_rate;   // du point de vue du camp qui a le trait
+  uint64_t playouts;
+  int rounds;
+  double ms;
+};
+
+struct FlatMc64_t {
+  Board64_t root;
+  bool white;
+  int nb_moves;
+  Move16_t moves[FLAT_MAX_MOVES];
+  Board64_t children[FLAT_MAX_MOVES];
+  std::atomic<uint32_t> visits[FLAT_MAX_MOVES];
+  std::atomic<uint32_t> wins[FLAT_MAX_MOVES];   // victoires du camp au trait
+  int alive[FLAT_MAX_MOVES];                    // coups restants, meilleurs en tête
+  int nb_alive;
+  std::atomic<uint64_t> next;                   // tourniquet de la manche
+  std::atomic<bool> stop;
+  std::vector<Rng64_t> rngs;
+
+  FlatMc64_t(int _nb_threads = 1, uint64_t _seed = 1ULL);
+  FlatResult_t think(const Board64_t& _b, bool _white, double _time_ms);
+  void playout(Rng64_t& _rng);
+  void worker(int _id);
+  double rate(int _m) const;
+};
+
+inline
+FlatMc64_t::FlatMc64_t(int _nb_threads, uint64_t _seed) : white(true), nb_moves(0), nb_alive(0), next(0), stop(false) {
+  if(_nb_threads < 1) _nb_threads = 1;
+  Rng64_t base(_seed);
+  for(int t = 0; t < _nb_threads; t++) rngs.push_back(base.split());
+}
+
+inline
+double FlatMc64_t::rate(int _m) const {
+  uint32_t v = visits[_m].load(std::memory_order_relaxed);
+  return v ? double(wins[_m].load(std::memory_order_relaxed))/v : 0.0;
+}
+
+// un playout du coup restant suivant dans le tourniquet
+inline
+void FlatMc64_t::playout(Rng64_t& _rng) {
+  int m = alive[next.fetch_add(1, std::memory_order_relaxed) % uint64_t(nb_alive)];
+  Board64_t b = children[m];
+  bool white_wins = b.seq_playout(!white, _rng);
+  visits[m].fetch_add(1, std::memory_order_relaxed);
+  if(white_wins == white) wins[m].fetch_add(1, std::memory_order_relaxed);
+}
+
+inline
+void FlatMc64_t::worker(int _id) {
+  pin_current_thread(_id);
+  while(!stop.load(std::memory_order_relaxed)) playout(rngs[_id]);
+}
+
+inline
+FlatResult_t FlatMc64_t::think(const Board64_t& _b, bool _white, double _time_ms) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  root = _b;
+  white = _white;
+  nb_moves = 0;
+  FlatResult_t res;
+  res.move = MOVE16_NONE;
+  res.win_rate = 0.0;
+  res.playouts = 0;
+  res.rounds = 0;
+  res.ms = 0.0;
+  Lfr_t lfr = _b.lfr(_white);
+  const uint64_t targets[4] = {0ULL, lfr.forward, lfr.left, lfr.right};
+  // 48 coups au plus avec 16 pions (parse_board64 refuse davantage) ; la
+  // borne protège quand même les tableaux fixes d'un plateau construit à la main
+  for(int d = DIR_FORWARD; d <= DIR_RIGHT; d++) {
+    for(uint64_t to = targets[d]; to && nb_moves < FLAT_MAX_MOVES; to &= to-1) {
+      Move16_t m = _b.move16(__builtin_ctzll(to)-dir_delta(d, _white), d, _white);
+      moves[nb_moves] = m;
+      children[nb_moves] = _b;
+      children[nb_moves].apply_move(m);
+      visits[nb_moves] = 0;
+      wins[nb_moves] = 0;
+      alive[nb_moves] = nb_moves;
+      // un coup gagnant se joue sans playout
+      if(children[nb_moves].win(_white)) {
+        res.move = m;
+        res.win_rate = 1.0;
+        return res;
+      }
+      nb_moves++;
+    }
+  }
+  nb_alive = nb_moves;
+  if(nb_moves <= 1) {
+    if(nb_moves == 1) res.move = moves[0];
+    return res;
+  }
+  int nb_rounds = 0;
+  while((1<<nb_rounds) < nb_moves) nb_rounds++;
+  pin_current_thread(0); // le thread appelant est le joueur 0
+  for(int r = 0; r < nb_rounds && nb_alive > 1; r++) {
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+    double slice = (_time_ms-elapsed)/(nb_rounds-r);
+    next = 0;
+    stop = false;
+    std::vector<std::thread> threads;
+    for(size_t t = 1; t < rngs.size(); t++) threads.push_back(std::thread(&FlatMc64_t::worker, this, int(t)));
+    // le thread appelant joue aussi et donne le signal d'arrêt : au moins un
+    // tour complet des coups restants pour qu'aucun ne soit classé sans playout
+    std::chrono::steady_clock::time_point round_start = std::chrono::steady_clock::now();
+    for(uint64_t k = 0; ; k++) {
+      playout(rngs[0]);
+      if((k & 15) == 15 && next.load(std::memory_order_relaxed) >= uint64_t(nb_alive) &&
+         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-round_start).count() >= slice)
+        break;
+    }
+    stop = true;
+    for(size_t t = 0; t < threads.size(); t++) threads[t].join();
+    std::stable_sort(alive, alive+nb_alive, [this](int _a, int _b) { return rate(_a) > rate(_b); });
+    nb_alive = (nb_alive+1)/2;
+    res.rounds++;
+  }
+  int best = alive[0];
+  for(int m = 0; m < nb_moves; m++) res.playouts += visits[m];
+  res.move = moves[best];
+  res.win_rate = rate(best);
+  res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+  return res;
+}
+
+#endif /* BKBB64_FLAT_H */
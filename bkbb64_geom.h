@@ -0,0 +1,37 @@
+// géométrie des plateaux de breakthrough W x H tenant sur 64 bits : case
+// i = ligne*W+colonne, ligne 0 en haut (but des blancs, départ des noirs),
+// colonne 0 à gauche (A). Masques et décalages sont des constantes de
+// compilation : le code instancié pour 8x8 est le même qu'avec les masques
+// écrits à la main (0xfefefefefefefefe, décalages 7/8/9, ...).
+#ifndef BKBB64_GEOM_H
+#define BKBB64_GEOM_H
+
+#include <cstdint>
+
+// _n bits de poids faible (0 <= _n <= 64)
+constexpr uint64_t geom_low_bits(int _n) {
+  return _n >= 64 ? ~0ULL : (1ULL<<_n)-1ULL;
+}
+// colonne _col des lignes _row à _h-1
+constexpr uint64_t geom_col(int _w, int _h, int _col, int _row = 0) {
+  return _row >= _h ? 0ULL : (1ULL<<(_row*_w+_col)) | geom_col(_w, _h, _col, _row+1);
+}
+
+template<int W, int H>
+struct Geom_t {
+  static_assert(W >= 2 && H >= 5 && W*H <= 64, "plateau de 2 colonnes et 5 lignes au moins, 64 cases au plus");
+  // décalages : les blancs montent (>>), les noirs descendent (<<) ; la
+  // diagonale vers la colonne A vaut W+1 pour les blancs, W-1 pour les noirs
+  enum { WIDTH = W, HEIGHT = H, SQUARES = W*H, FORWARD = W, DIAG_A_WHITE = W+1, DIAG_H_WHITE = W-1,
+         DIAG_A_BLACK = W-1, DIAG_H_BLACK = W+1 };
+  static constexpr uint64_t BOARD = geom_low_bits(W*H);
+  static constexpr uint64_t ROW_TOP = geom_low_bits(W);             // but des blancs
+  static constexpr uint64_t ROW_BOTTOM = geom_low_bits(W)<<(W*(H-1)); // but des noirs
+  static constexpr uint64_t NOT_COL_A = BOARD & ~geom_col(W, H, 0);
+  static constexpr uint64_t NOT_COL_LAST = BOARD & ~geom_col(W, H, W-1);
+  static constexpr uint64_t BLACK_START = geom_low_bits(2*W);       // deux lignes de pions
+  static constexpr uint64_t WHITE_START = geom_low_bits(2*W)<<(W*(H-2));
+  static constexpr uint64_t row(int _row) { return geom_low_bits(W)<<(W*_row); }
+};
+
+#endif /* BKBB64_GEOM_H */
@@ -0,0 +1,635 @@
+// monte carlo tree search sur bitboards pour breakthrough 8x8
+// statistiques en structure de tableaux : pour chaque noeud un coup codé sur
+// 8 bits (octet bas de Move16_t, le camp se déduit de la profondeur), deux
+// compteurs 32 bits et la plage contiguë de ses fils (14 octets par noeud) ;
+// les plateaux ne sont pas stockés mais rejoués depuis la racine. Entre deux
+// coups d'une même partie, reuse garde le sous-arbre de la nouvelle position.
+// Avec rave, deux compteurs amaf de plus par noeud (22 octets) : un coup
+// profite des playouts où son camp l'a joué plus tard (même case d'arrivée,
+// même direction). Avec les motifs, un score tactique par noeud (4 octets) :
+// les fils sont triés à l'expansion, seuls les meilleurs sont essayés tant
+// que le noeud a peu de visites (élargissement progressif) et le score
+// s'ajoute à ucb en décroissant avec les visites (biais progressif).
+// Les tableaux sont des LargeVector_t (pages de 2 Mo, numa : bkbb64_mem.h).
+#ifndef BKBB64_MCTS_H
+#define BKBB64_MCTS_H
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "bkbb64.h"
+#include "bkbb64_mem.h"
+
+static const uint32_t MCTS_NONE = 0xffffffff;
+static const int MCTS_MAX_CHILDREN = 64; // 16 pions, 3 coups au plus chacun (48)
+static const int MCTS_MAX_DEPTH = 256;   // une partie ne dépasse pas 16*6*2 demi-coups
+static const float MCTS_RAVE_K = 100.0f;  // réglages rave par défaut (mcts_bench rave)
+static const float MCTS_RAVE_C = 0.1f;
+static const float MCTS_PATTERN_BIAS = 2.0f; // réglages motifs par défaut (mcts_bench motifs)
+static const int MCTS_WIDEN_K0 = 4;
+static const float MCTS_WIDEN_A = 40.0f;     // un fils de plus à A, A*B, A*B^2... visites
+static const float MCTS_WIDEN_B = 1.4f;
+static const float MCTS_ZERO_PRIOR[MCTS_MAX_CHILDREN] = {};
+
+// version bitboard de evaluer_patterns_coup (breakthrough_simple.cpp) pour
+// tous les coups d'une position à la fois : chaque motif est un masque de
+// cases d'arrivée calculé une fois, un coup ne coûte que quelques tests de
+// bits. L'avancée d'une rangée (+200), commune à tous les coups, est omise
+struct MctsPatterns_t {
+  uint64_t goal;       // victoire
+  uint64_t pregoal;    // avant-dernière rangée
+  uint64_t capture;
+  uint64_t center;     // colonnes C à F
+  uint64_t support_l;  // pion allié en diagonale arrière
+  uint64_t support_r;
+  uint64_t threat;     // rangée de menace, bonus par allié déjà dessus
+  uint64_t jam;        // allié juste devant la case d'arrivée
+  int threat_bonus;
+  bool white;
+
+  MctsPatterns_t(const Board64_t& _b, bool _white);
+  int score(int _to) const;
+};
+
+inline
+MctsPatterns_t::MctsPatterns_t(const Board64_t& _b, bool _white) : white(_white) {
+  uint64_t own = _white ? _b.white : _b.black;
+  goal = _white ? ROW_8 : ROW_1;
+  pregoal = _white ? ROW_8<<8 : ROW_1>>8;
+  capture = _white ? _b.black : _b.white;
+  center = 0x3c3c3c3c3c3c3c3cULL;
+  // la rangée arrière est +8 pour les blancs, -8 pour les noirs
+  support_l = _white ? (own>>7) & COL_NOT_A : (own<<9) & COL_NOT_A;
+  support_r = _white ? (own>>9) & COL_NOT_H : (own<<7) & COL_NOT_H;
+  threat = _white ? ROW_8<<16 : ROW_1>>16;
+  threat_bonus = 150*__builtin_popcountll(own & threat);
+  jam = _white ? own<<8 : own>>8;
+}
+
+inline
+int MctsPatterns_t::score(int _to) const {
+  if((goal>>_to) & 1ULL) return 50000;
+  int row = _to>>3;
+  int s = 0;
+  if((pregoal>>_to) & 1ULL) s += 5000;
+  if((capture>>_to) & 1ULL) s += 800+50*(white ? 7-row : row);
+  if((center>>_to) & 1ULL) s += 100;
+  s += 80*int(((support_l>>_to) & 1ULL)+((support_r>>_to) & 1ULL));
+  if((threat>>_to) & 1ULL) s += threat_bonus;
+  if((jam>>_to) & 1ULL) s -= 200;
+  return s;
+}
+
+struct MctsResult_t {
+  Move16_t move;
+  uint32_t visits;   // visites du coup choisi
+  double win_rate;   // du point de vue du camp qui a le trait
+  uint64_t iterations;
+  uint64_t nodes;
+  double ms;
+};
+
+struct Mcts64_t {
+  // statistiques, un indice par noeud ; wins compte les victoires du camp
+  // qui a joué move
+  LargeVector_t<uint8_t> move;
+  LargeVector_t<uint8_t> nb_children;
+  LargeVector_t<uint32_t> first_child;
+  LargeVector_t<uint32_t> visits;
+  LargeVector_t<uint32_t> wins;
+  LargeVector_t<uint32_t> amaf_visits; // vides sans rave
+  LargeVector_t<uint32_t> amaf_wins;
+  LargeVector_t<float> prior;          // vide sans motifs
+
+  Board64_t root_board;
+  bool root_white;
+  size_t mem_bytes;
+  size_t max_nodes;
+  float c_uct;
+  float rave_k;      // équivalence rave : beta = sqrt(k/(3n+k)), 0 sans rave
+  float pattern_bias; // poids du biais progressif
+  int widen_k0;       // fils essayés au départ (0 : tous)
+  Rng64_t rng;
+  uint64_t iterations;
+
+  Mcts64_t(size_t _mem_bytes = size_t(256)<<20, uint64_t _seed = 1ULL);
+  size_t node_bytes() const {
+    return 2*sizeof(uint8_t)+3*sizeof(uint32_t)+(rave() ? 2*sizeof(uint32_t) : 0)+(patterns() ? sizeof(float) : 0);
+  }
+  bool rave() const { return rave_k > 0.0f; }
+  bool patterns() const { return pattern_bias > 0.0f || widen_k0 > 0; }
+  void set_memory(size_t _mem_bytes);
+  void set_rave(float _k, float _c_uct);
+  void set_patterns(float _bias, int _k0);
+  void reset(const Board64_t& _b, bool _white);
+  bool reuse(const Board64_t& _b, bool _white, uint32_t* _found = NULL);
+  void keep_subtree(uint32_t _id);
+  void reserve_nodes();
+  uint32_t add_node(uint8_t _m);
+  bool expand(uint32_t _id, const Board64_t& _b, bool _white);
+  int width(uint32_t _id) const;
+  uint32_t select_child(uint32_t _id) const;
+  uint32_t select_child_rave(uint32_t _id) const;
+  bool playout(Board64_t _b, bool _white, uint64_t* _to = NULL);
+  void update_amaf(const uint32_t* _path, int _depth, bool _white_wins, uint64_t* _to);
+  void iterate();
+  uint32_t best_child() const;
+  uint64_t run(double _time_ms, uint64_t _max_iter = 0);
+  MctsResult_t result() const;
+  MctsResult_t think(const Board64_t& _b, bool _white, double _time_ms, uint64_t _max_iter = 0);
+};
+
+inline
+Mcts64_t::Mcts64_t(size_t _mem_bytes, uint64_t _seed) : root_white(true), c_uct(0.7f), rave_k(0.0f),
+                                                        pattern_bias(0.0f), widen_k0(0), rng(_seed), iterations(0) {
+  set_memory(_mem_bytes);
+}
+inline
+void Mcts64_t::set_memory(size_t _mem_bytes) {
+  mem_bytes = _mem_bytes;
+  max_nodes = _mem_bytes/node_bytes();
+  if(max_nodes > MCTS_NONE-1) max_nodes = MCTS_NONE-1;
+}
+// à régler avant reset (les compteurs amaf suivent les autres tableaux)
+inline
+void Mcts64_t::set_rave(float _k, float _c_uct) {
+  rave_k = _k;
+  c_uct = _c_uct;
+  set_memory(mem_bytes);
+}
+// à régler avant reset, comme set_rave
+inline
+void Mcts64_t::set_patterns(float _bias, int _k0) {
+  pattern_bias = _bias;
+  widen_k0 = _k0;
+  set_memory(mem_bytes);
+}
+inline
+void Mcts64_t::reset(const Board64_t& _b, bool _white) {
+  move.clear();
+  nb_children.clear();
+  first_child.clear();
+  visits.clear();
+  wins.clear();
+  amaf_visits.clear();
+  amaf_wins.clear();
+  prior.clear();
+  root_board = _b;
+  root_white = _white;
+  iterations = 0;
+  reserve_nodes();
+  add_node(0);
+}
+// capacité de max_nodes pour chaque tableau : expand s'arrête à max_nodes,
+// les vecteurs ne doublent donc jamais au-delà de -mctsmem. Les pages de
+// LargeAllocator_t ne sont touchées qu'à l'écriture, la réserve ne coûte
+// rien d'avance
+inline
+void Mcts64_t::reserve_nodes() {
+  move.reserve(max_nodes);
+  nb_children.reserve(max_nodes);
+  first_child.reserve(max_nodes);
+  visits.reserve(max_nodes);
+  wins.reserve(max_nodes);
+  if(rave()) {
+    amaf_visits.reserve(max_nodes);
+    amaf_wins.reserve(max_nodes);
+  }
+  if(patterns()) prior.reserve(max_nodes);
+}
+// garde le sous-arbre de _b (_white au trait) s'il est à deux demi-coups au
+// plus de la racine ; false, arbre inchangé, si la position n'y est pas.
+// _found reçoit l'ancien indice du noeud gardé
+inline
+bool Mcts64_t::reuse(const Board64_t& _b, bool _white, uint32_t* _found) {
+  uint32_t found = MCTS_NONE;
+  if(root_board == _b && root_white == _white) found = 0;
+  for(uint32_t c = first_child[0]; found == MCTS_NONE && c < first_child[0]+nb_children[0]; c++) {
+    Board64_t b1 = root_board;
+    b1.apply_move(Move16_t::from_code8(move[c], root_white));
+    if(root_white != _white) {
+      if(b1 == _b) found = c;
+      continue;
+    }
+    for(uint32_t g = first_child[c]; g < first_child[c]+nb_children[c]; g++) {
+      Board64_t b2 = b1;
+      b2.apply_move(Move16_t::from_code8(move[g], !root_white));
+      if(b2 == _b) {
+        found = g;
+        break;
+      }
+    }
+  }
+  if(found == MCTS_NONE) return false;
+  if(_found) *_found = found;
+  keep_subtree(found);
+  root_board = _b;
+  root_white = _white;
+  iterations = 0;
+  return true;
+}
+
+// recopie le sous-arbre de _id en largeur d'abord, _id devient la racine 0 ;
+// chaque bloc de fils reste contigu
+inline
+void Mcts64_t::keep_subtree(uint32_t _id) {
+  if(_id == 0) return;
+  std::vector<uint32_t> old_id(1, _id);
+  old_id.reserve(move.size());
+  LargeVector_t<uint8_t> m2(1, 0);
+  LargeVector_t<uint8_t> nb2(1, nb_children[_id]);
+  LargeVector_t<uint32_t> fc2(1, MCTS_NONE);
+  LargeVector_t<uint32_t> v2(1, visits[_id]);
+  LargeVector_t<uint32_t> w2(1, wins[_id]);
+  LargeVector_t<uint32_t> av2(rave() ? 1 : 0, rave() ? amaf_visits[_id] : 0);
+  LargeVector_t<uint32_t> aw2(rave() ? 1 : 0, rave() ? amaf_wins[_id] : 0);
+  LargeVector_t<float> p2(patterns() ? 1 : 0, patterns() ? prior[_id] : 0.0f);
+  // copies réservées à max_nodes avant le parcours : pas de doublement ni de
+  // recopie, au plus l'ancien arbre et le sous-arbre gardé en mémoire
+  m2.reserve(max_nodes);
+  nb2.reserve(max_nodes);
+  fc2.reserve(max_nodes);
+  v2.reserve(max_nodes);
+  w2.reserve(max_nodes);
+  if(rave()) {
+    av2.reserve(max_nodes);
+    aw2.reserve(max_nodes);
+  }
+  if(patterns()) p2.reserve(max_nodes);
+  for(size_t i = 0; i < old_id.size(); i++) {
+    uint32_t o = old_id[i];
+    if(nb_children[o] == 0) continue;
+    fc2[i] = uint32_t(old_id.size());
+    for(uint32_t c = first_child[o]; c < first_child[o]+nb_children[o]; c++) {
+      old_id.push_back(c);
+      m2.push_back(move[c]);
+      nb2.push_back(nb_children[c]);
+      fc2.push_back(MCTS_NONE);
+      v2.push_back(visits[c]);
+      w2.push_back(wins[c]);
+      if(rave()) {
+        av2.push_back(amaf_visits[c]);
+        aw2.push_back(amaf_wins[c]);
+      }
+      if(patterns()) p2.push_back(prior[c]);
+    }
+  }
+  move.swap(m2);
+  nb_children.swap(nb2);
+  first_child.swap(fc2);
+  visits.swap(v2);
+  wins.swap(w2);
+  amaf_visits.swap(av2);
+  amaf_wins.swap(aw2);
+  prior.swap(p2);
+}
+
+inline
+uint32_t Mcts64_t::add_node(uint8_t _m) {
+  move.push_back(_m);
+  nb_children.push_back(0);
+  first_child.push_back(MCTS_NONE);
+  visits.push_back(0);
+  wins.push_back(0);
+  if(rave()) {
+    amaf_visits.push_back(0);
+    amaf_wins.push_back(0);
+  }
+  if(patterns()) prior.push_back(0.0f);
+  return uint32_t(move.size()-1);
+}
+
+// ajoute tous les fils de _id d'un bloc ; false si la mémoire est pleine.
+// Avec les motifs, le bloc est trié par score décroissant et le score
+// ramené à [0, 5] (milliers de points, les coups mauvais à 0) devient le prior
+inline
+bool Mcts64_t::expand(uint32_t _id, const Board64_t& _b, bool _white) {
+  Lfr_t lfr = _b.lfr(_white);
+  int nb = __builtin_popcountll(lfr.forward)+__builtin_popcountll(lfr.left)+__builtin_popcountll(lfr.right);
+  if(nb == 0 || move.size()+nb > max_nodes) return false;
+  uint32_t first = uint32_t(move.size());
+  const uint64_t targets[4] = {0ULL, lfr.forward, lfr.left, lfr.right};
+  if(!patterns()) {
+    for(int d = DIR_FORWARD; d <= DIR_RIGHT; d++) {
+      for(uint64_t to = targets[d]; to; to &= to-1)
+        add_node(Move16_t::make(__builtin_ctzll(to)-dir_delta(d, _white), d, _white).code8());
+    }
+  } else {
+    MctsPatterns_t pat(_b, _white);
+    uint8_t codes[MCTS_MAX_CHILDREN];
+    int scores[MCTS_MAX_CHILDREN];
+    int n = 0;
+    for(int d = DIR_FORWARD; d <= DIR_RIGHT; d++) {
+      for(uint64_t to = targets[d]; to; to &= to-1) {
+        int sq = __builtin_ctzll(to);
+        uint8_t code = Move16_t::make(sq-dir_delta(d, _white), d, _white).code8();
+        int s = pat.score(sq);
+        int j = n++;
+        for(; j > 0 && scores[j-1] < s; j--) { // tri par insertion, stable
+          scores[j] = scores[j-1];
+          codes[j] = codes[j-1];
+        }
+        scores[j] = s;
+        codes[j] = code;
+      }
+    }
+    for(int j = 0; j < n; j++) {
+      uint32_t c = add_node(codes[j]);
+      float h = float(scores[j])*0.001f;
+      prior[c] = h < 0.0f ? 0.0f : (h > 5.0f ? 5.0f : h);
+    }
+  }
+  first_child[_id] = first;
+  nb_children[_id] = uint8_t(nb);
+  return true;
+}
+
+// fils essayés par select_child : les widen_k0 premiers du bloc (les mieux
+// notés), un de plus à chaque palier de visites
+inline
+int Mcts64_t::width(uint32_t _id) const {
+  int nb = nb_children[_id];
+  if(widen_k0 == 0) return nb;
+  float n = float(visits[_id]);
+  int k = widen_k0;
+  if(n >= MCTS_WIDEN_A) k += 1+int(logf(n/MCTS_WIDEN_A)*(1.0f/logf(MCTS_WIDEN_B)));
+  return k < nb ? k : nb;
+}
+
+static inline
+float mcts_ucb(uint32_t _v, uint32_t _w, float _h, float _log_n, float _c) {
+  if(_v == 0) return 1e9f;
+  float inv = 1.0f/float(_v);
+  return float(_w)*inv+_h*inv+_c*sqrtf(_log_n*inv);
+}
+
+// ucb1 sur la plage contiguë des fils, 4 fils par instruction sse2 (sqrtf
+// empêche le compilateur de vectoriser seul à cause d'errno) ; les fils
+// jamais visités passent devant (score 1e9), à égalité le premier l'emporte.
+// Biais progressif : pattern_bias*prior/n s'ajoute au score
+inline
+uint32_t Mcts64_t::select_child(uint32_t _id) const {
+  uint32_t first = first_child[_id];
+  int nb = width(_id);
+  const uint32_t* v = &visits[first];
+  const uint32_t* w = &wins[first];
+  const float* h = patterns() ? &prior[first] : MCTS_ZERO_PRIOR;
+  float log_n = logf(float(visits[_id]+1));
+  float best_score = -1.0f;
+  int best = 0;
+  int i = 0;
+#ifdef __SSE2__
+  if(nb >= 4) {
+    const __m128 c = _mm_set1_ps(c_uct);
+    const __m128 bias = _mm_set1_ps(pattern_bias);
+    const __m128 ln = _mm_set1_ps(log_n);
+    const __m128 unvisited = _mm_set1_ps(1e9f);
+    const __m128i zero = _mm_setzero_si128();
+    __m128 best4 = _mm_set1_ps(-1.0f);
+    __m128i best_idx = _mm_setzero_si128();
+    __m128i idx = _mm_set_epi32(3, 2, 1, 0);
+    const __m128i four = _mm_set1_epi32(4);
+    for(; i+4 <= nb; i += 4) {
+      __m128i vi = _mm_loadu_si128((const __m128i*)(v+i));
+      __m128 n = _mm_cvtepi32_ps(vi);
+      __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(n, _mm_set1_ps(1.0f)));
+      __m128 q = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(w+i))), inv);
+      q = _mm_add_ps(q, _mm_mul_ps(_mm_mul_ps(bias, _mm_loadu_ps(h+i)), inv));
+      __m128 ucb = _mm_add_ps(q, _mm_mul_ps(c, _mm_sqrt_ps(_mm_mul_ps(ln, inv))));
+      __m128 zmask = _mm_castsi128_ps(_mm_cmpeq_epi32(vi, zero));
+      ucb = _mm_or_ps(_mm_and_ps(zmask, unvisited), _mm_andnot_ps(zmask, ucb));
+      __m128 gt = _mm_cmpgt_ps(ucb, best4);
+      best4 = _mm_or_ps(_mm_and_ps(gt, ucb), _mm_andnot_ps(gt, best4));
+      best_idx = _mm_or_si128(_mm_and_si128(_mm_castps_si128(gt), idx),
+                              _mm_andnot_si128(_mm_castps_si128(gt), best_idx));
+      idx = _mm_add_epi32(idx, four);
+    }
+    float s4[4];
+    int32_t i4[4];
+    _mm_storeu_ps(s4, best4);
+    _mm_storeu_si128((__m128i*)i4, best_idx);
+    for(int l = 0; l < 4; l++) {
+      if(s4[l] > best_score || (s4[l] == best_score && i4[l] < best)) {
+        best_score = s4[l];
+        best = i4[l];
+      }
+    }
+  }
+#endif
+  for(; i < nb; i++) {
+    float u = mcts_ucb(v[i], w[i], pattern_bias*h[i], log_n, c_uct);
+    if(u > best_score) {
+      best_score = u;
+      best = i;
+    }
+  }
+  return first+best;
+}
+
+static inline
+float mcts_rave(uint32_t _v, uint32_t _w, uint32_t _av, uint32_t _aw, float _h, float _log_n, float _c, float _k) {
+  float inv = 1.0f/float(_v > 0 ? _v : 1);
+  float qa = _av ? float(_aw)/float(_av) : 1.0f;
+  float beta = sqrtf(_k/(3.0f*float(_v)+_k));
+  return (1.0f-beta)*float(_w)*inv+beta*qa+_h*inv+_c*sqrtf(_log_n*inv);
+}
+
+// ucb mélangé aux statistiques amaf, beta = sqrt(k/(3n+k)) passe de 1 (fils
+// jamais visité : valeur amaf seule, 1 sans information) à 0 ; même
+// découpage sse2, élargissement et biais que select_child
+inline
+uint32_t Mcts64_t::select_child_rave(uint32_t _id) const {
+  uint32_t first = first_child[_id];
+  int nb = width(_id);
+  const uint32_t* v = &visits[first];
+  const uint32_t* w = &wins[first];
+  const uint32_t* av = &amaf_visits[first];
+  const uint32_t* aw = &amaf_wins[first];
+  const float* h = patterns() ? &prior[first] : MCTS_ZERO_PRIOR;
+  float log_n = logf(float(visits[_id]+1));
+  float best_score = -1.0f;
+  int best = 0;
+  int i = 0;
+#ifdef __SSE2__
+  if(nb >= 4) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 c = _mm_set1_ps(c_uct);
+    const __m128 k = _mm_set1_ps(rave_k);
+    const __m128 bias = _mm_set1_ps(pattern_bias);
+    const __m128 ln = _mm_set1_ps(log_n);
+    const __m128i zero = _mm_setzero_si128();
+    __m128 best4 = _mm_set1_ps(-1.0f);
+    __m128i best_idx = _mm_setzero_si128();
+    __m128i idx = _mm_set_epi32(3, 2, 1, 0);
+    const __m128i four = _mm_set1_epi32(4);
+    for(; i+4 <= nb; i += 4) {
+      __m128 n = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(v+i)));
+      __m128 inv = _mm_div_ps(one, _mm_max_ps(n, one));
+      __m128 q = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(w+i))), inv);
+      __m128i avi = _mm_loadu_si128((const __m128i*)(av+i));
+      __m128 na = _mm_cvtepi32_ps(avi);
+      __m128 qa = _mm_div_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(aw+i))), _mm_max_ps(na, one));
+      __m128 amask = _mm_castsi128_ps(_mm_cmpeq_epi32(avi, zero));
+      qa = _mm_or_ps(_mm_and_ps(amask, one), _mm_andnot_ps(amask, qa));
+      __m128 beta = _mm_sqrt_ps(_mm_div_ps(k, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(3.0f), n), k)));
+      __m128 s = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(one, beta), q), _mm_mul_ps(beta, qa));
+      s = _mm_add_ps(s, _mm_mul_ps(_mm_mul_ps(bias, _mm_loadu_ps(h+i)), inv));
+      s = _mm_add_ps(s, _mm_mul_ps(c, _mm_sqrt_ps(_mm_mul_ps(ln, inv))));
+      __m128 gt = _mm_cmpgt_ps(s, best4);
+      best4 = _mm_or_ps(_mm_and_ps(gt, s), _mm_andnot_ps(gt, best4));
+      best_idx = _mm_or_si128(_mm_and_si128(_mm_castps_si128(gt), idx),
+                              _mm_andnot_si128(_mm_castps_si128(gt), best_idx));
+      idx = _mm_add_epi32(idx, four);
+    }
+    float s4[4];
+    int32_t i4[4];
+    _mm_storeu_ps(s4, best4);
+    _mm_storeu_si128((__m128i*)i4, best_idx);
+    for(int l = 0; l < 4; l++) {
+      if(s4[l] > best_score || (s4[l] == best_score && i4[l] < best)) {
+        best_score = s4[l];
+        best = i4[l];
+      }
+    }
+  }
+#endif
+  for(; i < nb; i++) {
+    float u = mcts_rave(v[i], w[i], av[i], aw[i], pattern_bias*h[i], log_n, c_uct, rave_k);
+    if(u > best_score) {
+      best_score = u;
+      best = i;
+    }
+  }
+  return first+best;
+}
+
+// true si les blancs gagnent ; un camp sans coup perd. _to (rave) reçoit
+// les coups de chaque camp (voir seq_playout_record)
+inline
+bool Mcts64_t::playout(Board64_t _b, bool _white, uint64_t* _to) {
+  uint64_t to[6] = {0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL};
+  return _b.seq_playout_record(_white, rng, _to ? _to : to);
+}
+
+// amaf : en remontant le chemin, les fils de path[i] joués ensuite par le
+// même camp (dans l'arbre ou le playout) comptent cette partie comme s'ils
+// avaient été joués tout de suite
+inline
+void Mcts64_t::update_amaf(const uint32_t* _path, int _depth, bool _white_wins, uint64_t* _to) {
+  for(int i = _depth-1; i >= 0; i--) {
+    bool white = root_white != ((i & 1) != 0); // trait en path[i]
+    uint64_t* seen = _to+3*white;
+    if(i+1 < _depth) {
+      Move16_t m = Move16_t::from_code8(move[_path[i+1]], white);
+      seen[m.dir()-1] |= m.to_mask();
+    }
+    uint32_t first = first_child[_path[i]];
+    uint32_t won = (white == _white_wins) ? 1 : 0;
+    for(uint32_t c = first; c < first+nb_children[_path[i]]; c++) {
+      Move16_t m = Move16_t::from_code8(move[c], white);
+      if((seen[m.dir()-1]>>m.to()) & 1ULL) {
+        amaf_visits[c]++;
+        amaf_wins[c] += won;
+      }
+    }
+  }
+}
+
+// sélection, expansion d'un noeud, playout, rétropropagation
+inline
+void Mcts64_t::iterate() {
+  uint32_t path[MCTS_MAX_DEPTH];
+  int depth = 0;
+  uint32_t id = 0;
+  Board64_t b = root_board;
+  bool white = root_white;
+  path[depth++] = id;
+  bool white_wins;
+  uint64_t to[6] = {0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL};
+  while(1) {
+    if(b.win(!white)) { // le coup précédent a gagné
+      white_wins = !white;
+      break;
+    }
+    // une feuille est développée à sa deuxième visite (la racine tout de
+    // suite) ; sinon, ou si la mémoire est pleine, simple playout
+    if(nb_children[id] == 0 && ((visits[id] == 0 && id != 0) || !expand(id, b, white))) {
+      white_wins = playout(b, white, to);
+      break;
+    }
+    id = rave() ? select_child_rave(id) : select_child(id);
+    b.apply_move(Move16_t::from_code8(move[id], white));
+    white = !white;
+    path[depth++] = id;
+  }
+  // le noeud path[i] a été joué par le camp qui n'a pas le trait en path[i]
+  bool mover_white = !white;
+  for(int i = depth-1; i >= 0; i--) {
+    visits[path[i]]++;
+    if(mover_white == white_wins) wins[path[i]]++;
+    mover_white = !mover_white;
+  }
+  if(rave()) update_amaf(path, depth, white_wins, to);
+  iterations++;
+}
+
+// coup de la racine le plus visité
+inline
+uint32_t Mcts64_t::best_child() const {
+  uint32_t first = first_child[0];
+  uint32_t best = first;
+  for(uint32_t c = first+1; c < first+nb_children[0]; c++)
+    if(visits[c] > visits[best]) best = c;
+  return best;
+}
+
+// itérations pendant _time_ms (ou jusqu'à _max_iter au total) sur l'arbre
+// courant : plusieurs appels successifs poursuivent la même recherche
+inline
+uint64_t Mcts64_t::run(double _time_ms, uint64_t _max_iter) {
+  BK_PROF_SCOPE(PHASE_SEARCH);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint64_t first = iterations;
+  while(_max_iter == 0 || iterations < _max_iter) {
+    iterate();
+    if((iterations & 63) == 0 && _time_ms > 0.0 &&
+       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count() > _time_ms)
+      break;
+  }
+  return iterations-first;
+}
+
+// coup le plus visité de la racine (ms à remplir par l'appelant)
+inline
+MctsResult_t Mcts64_t::result() const {
+  MctsResult_t res;
+  res.move = MOVE16_NONE;
+  res.visits = 0;
+  res.win_rate = 0.0;
+  if(nb_children[0] > 0) {
+    uint32_t c = best_child();
+    Move16_t m = Move16_t::from_code8(move[c], root_white);
+    res.move = root_board.move16(m.from(), m.dir(), root_white);
+    res.visits = visits[c];
+    res.win_rate = visits[c] ? double(wins[c])/visits[c] : 0.0;
+  }
+  res.iterations = iterations;
+  res.nodes = move.size();
+  res.ms = 0.0;
+  return res;
+}
+
+inline
+MctsResult_t Mcts64_t::think(const Board64_t& _b, bool _white, double _time_ms, uint64_t _max_iter) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  reset(_b, _white);
+  run(_time_ms, _max_iter);
+  MctsResult_t res = result();
+  res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+  return res;
+}
+
+#endif /* BKBB64_MCTS_H */
@@ -0,0 +1,305 @@
+// mémoire des grandes tables (table de transposition, arbre mcts, pns) et
+// placement des threads. Au-delà de LARGE_MIN_BYTES, LargeAllocator_t
+// réserve par mmap, aligné sur 2 Mo :
+//  - pages de 2 Mo : MAP_HUGETLB (pages réservées par l'administrateur) si
+//    demandé, sinon madvise(MADV_HUGEPAGE) pour les pages transparentes,
+//    sinon pages normales ; chaque étape retombe sur la suivante ;
+//  - numa : première écriture (défaut), entrelacée sur tous les noeuds ou
+//    découpée en tranches contiguës, une par noeud (mbind, sans libnuma) ;
+// et pin_current_thread fixe le n-ième thread sur un coeur, en alternant
+// les noeuds numa. Réglages communs au processus (mem_options), à fixer
+// avant d'allouer les tables.
+#ifndef BKBB64_MEM_H
+#define BKBB64_MEM_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+static const size_t LARGE_PAGE = size_t(2)<<20;
+static const size_t LARGE_MIN_BYTES = LARGE_PAGE; // en dessous : operator new
+
+enum { HUGE_OFF = 0, HUGE_THP = 1, HUGE_TLB = 2 };
+enum { NUMA_LOCAL = 0, NUMA_INTERLEAVE = 1, NUMA_PARTITION = 2 };
+
+static const char* const HUGE_NAMES[3] = {"off", "thp", "tlb"};
+static const char* const NUMA_NAMES[3] = {"local", "interleave", "partition"};
+
+struct MemOptions_t {
+  int huge;
+  int numa;
+  bool pin;
+};
+
+// compteurs d'allocations selon ce qui a été obtenu
+struct MemStats_t {
+  std::atomic<uint64_t> hugetlb;
+  std::atomic<uint64_t> thp;
+  std::atomic<uint64_t> plain;
+  std::atomic<uint64_t> numa_placed;
+  std::atomic<uint64_t> numa_failed;
+  std::atomic<uint64_t> bytes;  // réservés par mmap, en cours
+};
+
+inline
+MemOptions_t& mem_options() {
+  static MemOptions_t o = {HUGE_THP, NUMA_LOCAL, false};
+  return o;
+}
+inline
+MemStats_t& mem_stats() {
+  static MemStats_t s;
+  return s;
+}
+
+// "off"/"thp"/"tlb", "local"/"interleave"/"partition" -> valeur, -1 sinon
+inline
+int mem_parse(const char* _s, const char* const* _names) {
+  for(int i = 0; i < 3; i++)
+    if(strcmp(_s, _names[i]) == 0) return i;
+  return -1;
+}
+
+// liste "0-3,8,10-11" de /sys -> entiers ; vide si le fichier manque
+inline
+std::vector<int> read_sys_list(const char* _path) {
+  std::vector<int> ret;
+  FILE* f = fopen(_path, "r");
+  if(!f) return ret;
+  int a, b;
+  while(fscanf(f, "%d", &a) == 1) {
+    b = a;
+    int c = fgetc(f);
+    if(c == '-') {
+      if(fscanf(f, "%d", &b) != 1) break;
+      c = fgetc(f);
+    }
+    for(int i = a; i <= b; i++) ret.push_back(i);
+    if(c != ',') break;
+  }
+  fclose(f);
+  return ret;
+}
+
+inline
+uint64_t read_numa_nodes() {
+  std::vector<int> l = read_sys_list("/sys/devices/system/node/online");
+  uint64_t nodes = 0;
+  for(size_t i = 0; i < l.size(); i++)
+    if(l[i] < 64) nodes |= 1ULL<<l[i];
+  return nodes ? nodes : 1ULL;
+}
+// noeuds numa en ligne (masque) ; 1 (noeud 0) si inconnu
+inline
+uint64_t numa_online_nodes() {
+  static const uint64_t nodes = read_numa_nodes();
+  return nodes;
+}
+
+static const int MPOL_BIND_ = 2;       // constantes de <numaif.h>
+static const int MPOL_INTERLEAVE_ = 3;
+
+inline
+bool numa_bind(void* _p, size_t _len, int _mode, uint64_t _nodes) {
+#ifdef SYS_mbind
+  unsigned long mask = (unsigned long)_nodes;
+  return syscall(SYS_mbind, _p, _len, _mode, &mask, sizeof(mask)*8+1, 0) == 0;
+#else
+  (void)_p; (void)_len; (void)_mode; (void)_nodes;
+  return false;
+#endif
+}
+
+// pages encore jamais écrites : la politique s'applique à la première
+// écriture ; en local (défaut) /sys n'est pas lu
+inline
+void numa_place(void* _p, size_t _len, int _numa) {
+  if(_numa == NUMA_LOCAL) return;
+  uint64_t nodes = numa_online_nodes();
+  int nb = __builtin_popcountll(nodes);
+  if(nb < 2) return;
+  bool ok = true;
+  if(_numa == NUMA_INTERLEAVE) {
+    ok = numa_bind(_p, _len, MPOL_INTERLEAVE_, nodes);
+  } else {
+    size_t slice = (_len/nb+LARGE_PAGE-1)/LARGE_PAGE*LARGE_PAGE;
+    size_t off = 0;
+    for(uint64_t n = nodes; n && off < _len; n &= n-1, off += slice) {
+      size_t len = off+slice < _len ? slice : _len-off;
+      ok = numa_bind((char*)_p+off, len, MPOL_BIND_, n & (~n+1)) && ok;
+    }
+  }
+  (ok ? mem_stats().numa_placed : mem_stats().numa_failed)++;
+}
+
+inline
+size_t large_round(size_t _bytes) {
+  return (_bytes+LARGE_PAGE-1)/LARGE_PAGE*LARGE_PAGE;
+}
+
+// mémoire à zéro, alignée sur 2 Mo ; std::bad_alloc si mmap échoue
+inline
+void* large_alloc(size_t _bytes) {
+  const MemOptions_t& o = mem_options();
+  size_t len = large_round(_bytes);
+  void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if(o.huge == HUGE_TLB) {
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(p != MAP_FAILED) mem_stats().hugetlb++;
+  }
+#endif
+  if(p == MAP_FAILED) {
+    // 2 Mo de plus puis on rogne : le noyau ne forme une grande page que sur
+    // une adresse alignée
+    char* q = (char*)mmap(NULL, len+LARGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(q == MAP_FAILED) throw std::bad_alloc();
+    char* a = (char*)((uintptr_t(q)+LARGE_PAGE-1) & ~uintptr_t(LARGE_PAGE-1));
+    if(a > q) munmap(q, a-q);
+    if(a+len < q+len+LARGE_PAGE) munmap(a+len, q+len+LARGE_PAGE-(a+len));
+    p = a;
+    bool thp = false;
+#ifdef MADV_HUGEPAGE
+    if(o.huge != HUGE_OFF) thp = madvise(p, len, MADV_HUGEPAGE) == 0;
+#endif
+    (thp ? mem_stats().thp : mem_stats().plain)++;
+  }
+  numa_place(p, len, o.numa);
+  mem_stats().bytes += len;
+  return p;
+}
+inline
+void large_free(void* _p, size_t _bytes) {
+  size_t len = large_round(_bytes);
+  munmap(_p, len);
+  mem_stats().bytes -= len;
+}
+
+// allocateur des vecteurs de grandes tables : mmap au-delà de
+// LARGE_MIN_BYTES, operator new en dessous (le choix ne dépend que de la
+// taille, libérer n'a pas besoin de savoir ce qui a été obtenu)
+template<class T>
+struct LargeAllocator_t {
+  typedef T value_type;
+  LargeAllocator_t() {}
+  template<class U> LargeAllocator_t(const LargeAllocator_t<U>&) {}
+  T* allocate(size_t _n) {
+    size_t b = _n*sizeof(T);
+    if(b < LARGE_MIN_BYTES) return static_cast<T*>(::operator new(b));
+    return static_cast<T*>(large_alloc(b));
+  }
+  void deallocate(T* _p, size_t _n) {
+    size_t b = _n*sizeof(T);
+    if(b < LARGE_MIN_BYTES) ::operator delete(_p);
+    else large_free(_p, b);
+  }
+};
+template<class T, class U>
+bool operator== (const LargeAllocator_t<T>&, const LargeAllocator_t<U>&) { return true; }
+template<class T, class U>
+bool operator!= (const LargeAllocator_t<T>&, const LargeAllocator_t<U>&) { return false; }
+
+template<class T> using LargeVector_t = std::vector<T, LargeAllocator_t<T> >;
+
+// tableau de taille fixe à zéro (table de transposition) : la mémoire
+// neuve de large_alloc est déjà à zéro, l'allocation n'écrit donc rien et
+// chaque page n'est prise qu'à sa première écriture, pendant la recherche
+// (un coup unique ne paie pas la mise à zéro de toute la table au
+// lancement). T doit être valide tout à zéro.
+template<class T>
+struct LargeArray_t {
+  T* data;
+  size_t count;
+
+  LargeArray_t() : data(NULL), count(0) {}
+  ~LargeArray_t() { reset(0); }
+  LargeArray_t(const LargeArray_t&) = delete;
+  LargeArray_t& operator=(const LargeArray_t&) = delete;
+  // _n éléments à zéro ; std::bad_alloc si l'allocation échoue
+  void reset(size_t _n) {
+    if(data) {
+      if(bytes() < LARGE_MIN_BYTES) free(data);
+      else large_free(data, bytes());
+    }
+    data = NULL;
+    count = 0;
+    if(_n == 0) return;
+    size_t b = _n*sizeof(T);
+    data = static_cast<T*>(b < LARGE_MIN_BYTES ? calloc(_n, sizeof(T)) : large_alloc(b));
+    if(!data) throw std::bad_alloc();
+    count = _n;
+  }
+  void zero() {
+    if(count) memset((void*)data, 0, bytes());
+  }
+  size_t size() const { return count; }
+  size_t bytes() const { return count*sizeof(T); }
+  T& operator[](size_t _i) { return data[_i]; }
+  const T& operator[](size_t _i) const { return data[_i]; }
+};
+
+// coeurs permis au processus, un noeud numa après l'autre (noeud 0 coeur 0,
+// noeud 1 coeur 0, noeud 0 coeur 1, ...) : des threads consécutifs se
+// répartissent sur les sockets
+inline
+std::vector<int> read_pin_cpus() {
+  std::vector<int> cpus;
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return cpus;
+  std::vector<std::vector<int> > per_node;
+  uint64_t nodes = numa_online_nodes();
+  for(int n = 0; n < 64; n++) {
+    if(!((nodes>>n) & 1ULL)) continue;
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+    std::vector<int> all = read_sys_list(path);
+    std::vector<int> list;
+    for(size_t i = 0; i < all.size(); i++)
+      if(all[i] < CPU_SETSIZE && CPU_ISSET(all[i], &allowed)) list.push_back(all[i]);
+    if(!list.empty()) per_node.push_back(list);
+  }
+  for(size_t i = 0; ; i++) {
+    bool any = false;
+    for(size_t n = 0; n < per_node.size(); n++) {
+      if(i < per_node[n].size()) {
+        cpus.push_back(per_node[n][i]);
+        any = true;
+      }
+    }
+    if(!any) break;
+  }
+  if(cpus.empty()) // pas de /sys : les coeurs permis dans l'ordre
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      if(CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+  return cpus;
+}
+inline
+const std::vector<int>& pin_cpus() {
+  static const std::vector<int> cpus = read_pin_cpus();
+  return cpus;
+}
+
+// fixe le thread courant sur le coeur _index (modulo) si mem_options().pin ;
+// false si non demandé ou refusé
+inline
+bool pin_current_thread(int _index) {
+  if(!mem_options().pin) return false;
+  const std::vector<int>& cpus = pin_cpus();
+  if(cpus.empty()) return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpus[size_t(_index) % cpus.size()], &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+#endif /* BKBB64_MEM_H */
@@ -0,0 +1,141 @@
+// notation des plateaux : 64 caractères, case 0 = A8, ligne par ligne.
+// Deux alphabets acceptés : '1' noir, '0' blanc, '.' vide (breakthrough_simple,
+// pont Ludii) et '@' noir, 'O' blanc, '.' vide (bkbb64, rand_player).
+// Le parseur lit la chaîne sur place, sans allocation ; 16 ou 32 cases par
+// comparaison sse2/avx2 et movemask quand c'est disponible.
+#ifndef BKBB64_NOTATION_H
+#define BKBB64_NOTATION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+enum { ALPHABET_DIGITS = 0, ALPHABET_SYMBOLS = 1 };
+
+enum {
+  BOARD_PARSE_OK = 0,
+  BOARD_PARSE_LENGTH,   // pas exactement 64 caractères
+  BOARD_PARSE_CHAR,     // caractère hors des deux alphabets
+  BOARD_PARSE_MIXED,    // '0'/'1' et 'O'/'@' dans le même plateau
+  BOARD_PARSE_COUNT     // plus de 16 pions d'un camp
+};
+
+// au plus 16 pions par camp : les listes de coups (48 au plus) sont de
+// taille fixe, un plateau plus garni les déborderait
+static const int BOARD_MAX_PAWNS = 16;
+
+static const char* const BOARD_PARSE_ERRORS[5] = {
+  "ok", "longueur differente de 64", "caractere invalide", "alphabets melanges", "plus de 16 pions d'un camp"};
+
+// masques 64 bits des cases égales à chaque caractère
+struct BoardMasks_t {
+  uint64_t digit_black; // '1'
+  uint64_t digit_white; // '0'
+  uint64_t sym_black;   // '@'
+  uint64_t sym_white;   // 'O'
+  uint64_t empty;       // '.'
+};
+
+static inline
+BoardMasks_t board_masks(const char* _s) {
+  BoardMasks_t m;
+#if defined(__AVX2__)
+  uint32_t r[5][2];
+  for(int k = 0; k < 2; k++) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(_s+32*k));
+    r[0][k] = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('1'))));
+    r[1][k] = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('0'))));
+    r[2][k] = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('@'))));
+    r[3][k] = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('O'))));
+    r[4][k] = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))));
+  }
+  uint64_t* out[5] = {&m.digit_black, &m.digit_white, &m.sym_black, &m.sym_white, &m.empty};
+  for(int c = 0; c < 5; c++) *out[c] = uint64_t(r[c][0]) | (uint64_t(r[c][1])<<32);
+#elif defined(__SSE2__)
+  uint64_t* out[5] = {&m.digit_black, &m.digit_white, &m.sym_black, &m.sym_white, &m.empty};
+  static const char chars[5] = {'1', '0', '@', 'O', '.'};
+  for(int c = 0; c < 5; c++) *out[c] = 0ULL;
+  for(int k = 0; k < 4; k++) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(_s+16*k));
+    for(int c = 0; c < 5; c++) {
+      uint64_t bits = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(chars[c]))));
+      *out[c] |= bits<<(16*k);
+    }
+  }
+#else
+  // sans simd : un bit de classe par caractère, accumulé sans branche
+  memset(&m, 0, sizeof(m));
+  for(int i = 0; i < 64; i++) {
+    unsigned char ch = (unsigned char)_s[i];
+    m.digit_black |= uint64_t(ch == '1')<<i;
+    m.digit_white |= uint64_t(ch == '0')<<i;
+    m.sym_black |= uint64_t(ch == '@')<<i;
+    m.sym_white |= uint64_t(ch == 'O')<<i;
+    m.empty |= uint64_t(ch == '.')<<i;
+  }
+#endif
+  return m;
+}
+
+// _s[0.._len) -> bitboards ; _alphabet reçoit l'alphabet détecté (un plateau
+// vide est ALPHABET_DIGITS). Rien n'est écrit en cas d'erreur.
+static inline
+int parse_board64(const char* _s, size_t _len, uint64_t& _white, uint64_t& _black, int* _alphabet = NULL) {
+  if(_len != 64) return BOARD_PARSE_LENGTH;
+  BoardMasks_t m = board_masks(_s);
+  uint64_t digits = m.digit_black | m.digit_white;
+  uint64_t symbols = m.sym_black | m.sym_white;
+  if((digits | symbols | m.empty) != ~0ULL) return BOARD_PARSE_CHAR;
+  if(digits && symbols) return BOARD_PARSE_MIXED;
+  if(__builtin_popcountll(m.digit_white | m.sym_white) > BOARD_MAX_PAWNS ||
+     __builtin_popcountll(m.digit_black | m.sym_black) > BOARD_MAX_PAWNS)
+    return BOARD_PARSE_COUNT;
+  _white = m.digit_white | m.sym_white;
+  _black = m.digit_black | m.sym_black;
+  if(_alphabet) *_alphabet = symbols ? ALPHABET_SYMBOLS : ALPHABET_DIGITS;
+  return BOARD_PARSE_OK;
+}
+static inline
+int parse_board64(const char* _s, uint64_t& _white, uint64_t& _black, int* _alphabet = NULL) {
+  return parse_board64(_s, strlen(_s), _white, _black, _alphabet);
+}
+
+// camp au trait : "0"/"O" blancs (1), "1"/"@" noirs (0), -1 sinon
+static inline
+int parse_side(const char* _s) {
+  if(_s[0] == '\0' || _s[1] != '\0') return -1;
+  if(_s[0] == '0' || _s[0] == 'O') return 1;
+  if(_s[0] == '1' || _s[0] == '@') return 0;
+  return -1;
+}
+
+// 8 bits -> 8 octets 0/1 (bit i dans l'octet i)
+static inline
+uint64_t spread_byte(uint64_t _b) {
+  uint64_t x = (_b*0x0101010101010101ULL) & 0x8040201008040201ULL;
+  return ((x+0x7f7f7f7f7f7f7f7fULL)>>7) & 0x0101010101010101ULL;
+}
+
+// écrit les 64 caractères (sans zéro final) dans _out
+static inline
+void format_board64(uint64_t _white, uint64_t _black, int _alphabet, char* _out) {
+  const uint64_t ones = 0x0101010101010101ULL;
+  uint64_t empty = ones*'.';
+  uint64_t dw = uint64_t((_alphabet == ALPHABET_SYMBOLS ? 'O' : '0')-'.');
+  uint64_t db = uint64_t((_alphabet == ALPHABET_SYMBOLS ? '@' : '1')-'.');
+  for(int r = 0; r < 8; r++) {
+    uint64_t row = empty+spread_byte((_white>>(8*r)) & 0xff)*dw+spread_byte((_black>>(8*r)) & 0xff)*db;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for(int c = 0; c < 8; c++) _out[8*r+c] = char(row>>(8*c));
+#else
+    memcpy(_out+8*r, &row, 8); // octet 0 = colonne A
+#endif
+  }
+}
+
+#endif /* BKBB64_NOTATION_H */
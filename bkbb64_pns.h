@@ -0,0 +1,256 @@
+// solveur proof-number search (pns) sur bitboards pour breakthrough 8x8
+// arbre complet en mémoire dans une table de noeuds compacts de taille bornée
+#ifndef BKBB64_PNS_H
+#define BKBB64_PNS_H
+
+#include <chrono>
+#include <vector>
+#include "bkbb64_search.h"
+
+static const uint32_t PNS_INF = 0x3fffffff;
+static const uint32_t PNS_NONE = 0xffffffff;
+
+enum { PNS_UNKNOWN = 0, PNS_WIN = 1, PNS_LOSS = 2 };
+
+// 40 octets : la position, les nombres de preuve et de réfutation et les liens
+struct PnsNode_t {
+  uint64_t white;
+  uint64_t black;
+  uint32_t pn;
+  uint32_t dn;
+  uint32_t parent;
+  uint32_t first_child; // les fils sont contigus
+  Move16_t move;         // coup qui mène à ce noeud
+  uint8_t nb_children;
+  uint8_t white_to_move;
+};
+
+struct PnsResult_t {
+  int status;           // du point de vue du camp qui a le trait
+  Move16_t move;        // coup gagnant si status == PNS_WIN
+  uint32_t proof_size;  // noeuds de l'arbre de preuve
+  uint64_t nodes;
+  double ms;
+};
+
+static inline
+uint32_t pns_add(uint32_t _a, uint32_t _b) {
+  uint32_t s = _a+_b;
+  return s > PNS_INF ? PNS_INF : s;
+}
+
+// le solveur est un camp "attaquant" (celui qui a le trait à la racine) qui
+// cherche une victoire forcée ; comme il n'y a pas de nulle, réfuter la
+// victoire prouve la défaite
+struct PnsSolver_t {
+  LargeVector_t<PnsNode_t> nodes;
+  size_t max_nodes;
+  bool attacker;
+
+  PnsSolver_t(size_t _mem_bytes = size_t(64)<<20) { set_memory(_mem_bytes); }
+  void set_memory(size_t _mem_bytes) {
+    max_nodes = _mem_bytes/sizeof(PnsNode_t);
+    if(max_nodes > PNS_NONE-1) max_nodes = PNS_NONE-1;
+  }
+  bool is_or(const PnsNode_t& _n) const { return (_n.white_to_move != 0) == attacker; }
+  void init_node(PnsNode_t& _n);
+  bool expand(uint32_t _id);
+  void update(uint32_t _id);
+  uint32_t most_proving(uint32_t _id) const;
+  uint32_t proof_size(uint32_t _id) const;
+  PnsResult_t solve(const Board64_t& _b, bool _white, double _time_ms);
+};
+
+// nombres initiaux d'une feuille : terminaux, victoire en un coup,
+// sinon initialisation par la mobilité
+inline
+void PnsSolver_t::init_node(PnsNode_t& _n) {
+  Board64_t b;
+  b.white = _n.white;
+  b.black = _n.black;
+  bool white = _n.white_to_move != 0;
+  bool side_wins;
+  if(b.win(!white)) {
+    side_wins = false;
+  } else {
+    Lfr_t lfr = b.lfr(white);
+    uint64_t all = lfr.forward | lfr.left | lfr.right;
+    if(all & goal_row(white)) {
+      side_wins = true;
+    } else if(all == 0ULL) {
+      side_wins = false; // bloqué : perdu
+    } else {
+      int nb = __builtin_popcountll(lfr.forward)+__builtin_popcountll(lfr.left)+__builtin_popcountll(lfr.right);
+      if(is_or(_n)) { _n.pn = 1; _n.dn = nb; }
+      else { _n.pn = nb; _n.dn = 1; }
+      return;
+    }
+  }
+  bool proven = (side_wins == is_or(_n));
+  _n.pn = proven ? 0 : PNS_INF;
+  _n.dn = proven ? PNS_INF : 0;
+}
+
+inline
+bool PnsSolver_t::expand(uint32_t _id) {
+  Board64_t b;
+  b.white = nodes[_id].white;
+  b.black = nodes[_id].black;
+  bool white = nodes[_id].white_to_move != 0;
+  MoveList64_t l;
+  gen_moves(b, white, l);
+  if(nodes.size()+l.size > max_nodes) return false;
+  uint32_t first = uint32_t(nodes.size());
+  for(int i = 0; i < l.size; i++) {
+    Board64_t child = b;
+    child.apply_move(l.moves[i].move);
+    PnsNode_t n;
+    n.white = child.white;
+    n.black = child.black;
+    n.parent = _id;
+    n.first_child = PNS_NONE;
+    n.nb_children = 0;
+    n.move = l.moves[i].move;
+    n.white_to_move = !white;
+    init_node(n);
+    nodes.push_back(n);
+  }
+  nodes[_id].first_child = first;
+  nodes[_id].nb_children = uint8_t(l.size);
+  return true;
+}
+
+// recalcule les nombres de _id puis de ses ancêtres tant qu'ils changent
+inline
+void PnsSolver_t::update(uint32_t _id) {
+  while(_id != PNS_NONE) {
+    PnsNode_t& n = nodes[_id];
+    uint32_t pn, dn;
+    if(is_or(n)) {
+      pn = PNS_INF; dn = 0;
+      for(uint32_t c = n.first_child; c < n.first_child+n.nb_children; c++) {
+        if(nodes[c].pn < pn) pn = nodes[c].pn;
+        dn = pns_add(dn, nodes[c].dn);
+      }
+    } else {
+      pn = 0; dn = PNS_INF;
+      for(uint32_t c = n.first_child; c < n.first_child+n.nb_children; c++) {
+        pn = pns_add(pn, nodes[c].pn);
+        if(nodes[c].dn < dn) dn = nodes[c].dn;
+      }
+    }
+    if(pn == n.pn && dn == n.dn) break;
+    n.pn = pn;
+    n.dn = dn;
+    _id = n.parent;
+  }
+}
+
+inline
+uint32_t PnsSolver_t::most_proving(uint32_t _id) const {
+  while(nodes[_id].first_child != PNS_NONE) {
+    const PnsNode_t& n = nodes[_id];
+    uint32_t best = n.first_child;
+    for(uint32_t c = n.first_child+1; c < n.first_child+n.nb_children; c++) {
+      if(is_or(n) ? nodes[c].pn < nodes[best].pn : nodes[c].dn < nodes[best].dn) best = c;
+    }
+    _id = best;
+  }
+  return _id;
+}
+
+// taille de l'arbre de preuve : un fils prouvé sous un noeud OU,
+// tous les fils sous un noeud ET
+inline
+uint32_t PnsSolver_t::proof_size(uint32_t _id) const {
+  std::vector<uint32_t> stack(1, _id);
+  uint32_t size = 0;
+  while(!stack.empty()) {
+    uint32_t id = stack.back();
+    stack.pop_back();
+    size++;
+    const PnsNode_t& n = nodes[id];
+    if(n.first_child == PNS_NONE) continue;
+    bool want_proof = (n.pn == 0);
+    for(uint32_t c = n.first_child; c < n.first_child+n.nb_children; c++) {
+      bool solved = want_proof ? nodes[c].pn == 0 : nodes[c].dn == 0;
+      if(is_or(n) == want_proof) {
+        if(solved) { stack.push_back(c); break; }
+      } else {
+        stack.push_back(c);
+      }
+    }
+  }
+  return size;
+}
+
+inline
+PnsResult_t PnsSolver_t::solve(const Board64_t& _b, bool _white, double _time_ms) {
+  BK_PROF_SCOPE(PHASE_PNS);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  PnsResult_t res;
+  res.status = PNS_UNKNOWN;
+  res.move = MOVE16_NONE;
+  res.proof_size = 0;
+  attacker = _white;
+  nodes.clear();
+  // capacité bornée par -pnsmem : expand refuse au-delà, le vecteur ne
+  // double jamais ; pages touchées seulement à l'écriture
+  nodes.reserve(max_nodes);
+  PnsNode_t root;
+  root.white = _b.white;
+  root.black = _b.black;
+  root.parent = PNS_NONE;
+  root.first_child = PNS_NONE;
+  root.nb_children = 0;
+  root.move = MOVE16_NONE;
+  root.white_to_move = _white;
+  init_node(root);
+  nodes.push_back(root);
+
+  uint64_t iter = 0;
+  while(nodes[0].pn != 0 && nodes[0].dn != 0) {
+    if((++iter & 255) == 0 && _time_ms > 0.0 &&
+       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count() > _time_ms)
+      break;
+    BK_PROF_COUNT(PROF_NODES);
+    uint32_t mpn = most_proving(0);
+    if(!expand(mpn)) break; // budget mémoire atteint
+    update(mpn);
+  }
+
+  const PnsNode_t& r = nodes[0];
+  if(r.pn == 0) {
+    res.status = PNS_WIN;
+    res.proof_size = proof_size(0);
+    if(r.first_child == PNS_NONE) { // victoire en un coup
+      MoveList64_t l;
+      gen_moves(_b, _white, l);
+      for(int i = 0; i < l.size; i++)
+        if(l.moves[i].move.to_mask() & goal_row(_white)) { res.move = l.moves[i].move; break; }
+    } else {
+      for(uint32_t c = r.first_child; c < r.first_child+r.nb_children; c++) {
+        if(nodes[c].pn == 0) {
+          res.move = nodes[c].move;
+          break;
+        }
+      }
+    }
+  } else if(r.dn == 0) {
+    res.status = PNS_LOSS;
+    res.proof_size = proof_size(0);
+  }
+  res.nodes = nodes.size();
+  res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+  return res;
+}
+
+// une victoire forcée est plausible quand un camp a des pions
+// à deux lignes ou moins de son but (lignes 1-2 ou 6-7 du tableau)
+inline
+bool pns_worth_probing(const Board64_t& _b) {
+  return (_b.white & (row_mask(1) | row_mask(2))) != 0ULL ||
+         (_b.black & (row_mask(5) | row_mask(6))) != 0ULL;
+}
+
+#endif /* BKBB64_PNS_H */
@@ -0,0 +1,126 @@
+// réserve de threads à vol de tâches pour le mode serveur : une file par
+// thread, les nouvelles tâches sont réparties en tourniquet et un thread
+// sans travail vole dans la file des autres. Une tâche travaille une tranche
+// de temps puis renvoie true pour repasser en fin de file : les recherches
+// de plusieurs parties avancent à tour de rôle sur les mêmes coeurs.
+// Les tâches de fond (réflexion sur le temps de l'adversaire) ne passent
+// que quand aucune tâche normale n'attend, dans aucune file.
+#ifndef BKBB64_POOL_H
+#define BKBB64_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bkbb64_mem.h"
+
+// true : à reprendre après les autres tâches en file
+typedef std::function<bool()> PoolTask_t;
+
+struct WorkPool_t {
+  struct Queue_t {
+    std::mutex lock;
+    std::deque<PoolTask_t> tasks;
+    std::deque<PoolTask_t> background;
+  };
+  std::vector<Queue_t*> queues;
+  std::vector<std::thread> workers;
+  std::mutex sleep_lock;
+  std::condition_variable wake;
+  int64_t pending; // tâches en file (sous sleep_lock)
+  std::atomic<int64_t> waiting; // tâches normales en file : une tâche de fond longue doit céder
+  bool quit;
+  std::atomic<uint32_t> next_queue;
+  std::atomic<uint64_t> slices;
+  std::atomic<uint64_t> steals;
+
+  WorkPool_t(int _nb_threads);
+  ~WorkPool_t();
+  int size() const { return int(queues.size()); }
+  void push(const PoolTask_t& _t, int _queue = -1, bool _background = false);
+  bool pop(int _id, PoolTask_t& _t, bool& _background);
+  void worker(int _id);
+};
+
+inline
+WorkPool_t::WorkPool_t(int _nb_threads) : pending(0), waiting(0), quit(false), next_queue(0), slices(0), steals(0) {
+  if(_nb_threads < 1) _nb_threads = 1;
+  for(int i = 0; i < _nb_threads; i++) queues.push_back(new Queue_t());
+  for(int i = 0; i < _nb_threads; i++) workers.push_back(std::thread(&WorkPool_t::worker, this, i));
+}
+
+// les tâches en file sont terminées avant l'arrêt
+inline
+WorkPool_t::~WorkPool_t() {
+  {
+    std::lock_guard<std::mutex> g(sleep_lock);
+    quit = true;
+  }
+  wake.notify_all();
+  for(size_t i = 0; i < workers.size(); i++) workers[i].join();
+  for(size_t i = 0; i < queues.size(); i++) delete queues[i];
+}
+
+inline
+void WorkPool_t::push(const PoolTask_t& _t, int _queue, bool _background) {
+  if(_queue < 0) _queue = int(next_queue++ % queues.size());
+  {
+    std::lock_guard<std::mutex> g(sleep_lock);
+    pending++;
+  }
+  if(!_background) waiting++;
+  {
+    std::lock_guard<std::mutex> g(queues[_queue]->lock);
+    (_background ? queues[_queue]->background : queues[_queue]->tasks).push_back(_t);
+  }
+  wake.notify_one();
+}
+
+// tête de sa propre file, sinon tête de la file d'un autre thread (la tâche
+// qui attend depuis le plus longtemps) ; les tâches de fond en dernier
+inline
+bool WorkPool_t::pop(int _id, PoolTask_t& _t, bool& _background) {
+  int n = int(queues.size());
+  for(int pass = 0; pass < 2; pass++) {
+    for(int k = 0; k < n; k++) {
+      Queue_t* q = queues[(_id+k) % n];
+      std::lock_guard<std::mutex> g(q->lock);
+      std::deque<PoolTask_t>& d = pass ? q->background : q->tasks;
+      if(d.empty()) continue;
+      _t = d.front();
+      d.pop_front();
+      _background = pass != 0;
+      if(!_background) waiting--;
+      if(k > 0) steals++;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline
+void WorkPool_t::worker(int _id) {
+  pin_current_thread(_id);
+  PoolTask_t t;
+  bool background;
+  while(1) {
+    if(!pop(_id, t, background)) {
+      std::unique_lock<std::mutex> g(sleep_lock);
+      // pending peut précéder de peu l'ajout dans la file : on reboucle
+      wake.wait(g, [this]() { return pending > 0 || quit; });
+      if(pending == 0 && quit) return;
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> g(sleep_lock);
+      pending--;
+    }
+    slices++;
+    if(t()) push(t, _id, background);
+  }
+}
+
+#endif /* BKBB64_POOL_H */
@@ -0,0 +1,149 @@
+// base de positions des parties jouées (auto-jeu, tournois) : pour chaque
+// position (clé canonique, à la symétrie près) et chaque coup joué depuis
+// elle, nombre de parties et de victoires du camp au trait. Fichier trié
+// par (clé, coup), lu par mmap comme le livre : une recherche dichotomique
+// donne toutes les lignes d'une position. Construit par tri externe
+// (posdb_builder) : des séries triées écrites sur disque puis fusionnées.
+// format : PosDbHeader_t puis nb_entries PosDbEntry_t
+#ifndef BKBB64_POSDB_H
+#define BKBB64_POSDB_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bkbb64.h"
+
+static const char POSDB_MAGIC[8] = {'B','K','P','O','S','D','B','1'};
+
+struct PosDbHeader_t {
+  char magic[8];
+  uint64_t nb_entries;
+  uint64_t nb_games;
+};
+
+// 24 octets : coup dans l'orientation de la clé (Move16_t::code8, le camp
+// est celui de la clé, la prise se relit sur le plateau)
+struct PosDbEntry_t {
+  uint64_t key;
+  uint32_t games;
+  uint32_t wins;  // victoires du camp au trait
+  uint16_t move;
+  uint16_t pad[3];
+};
+
+static inline
+bool posdb_entry_less(const PosDbEntry_t& _a, const PosDbEntry_t& _b) {
+  return _a.key < _b.key || (_a.key == _b.key && _a.move < _b.move);
+}
+static inline
+bool posdb_same(const PosDbEntry_t& _a, const PosDbEntry_t& _b) {
+  return _a.key == _b.key && _a.move == _b.move;
+}
+
+// statistiques d'un coup, dans l'orientation de la position demandée
+struct PosDbMove_t {
+  Move16_t move;
+  uint32_t games;
+  uint32_t wins;
+};
+
+struct PosDb_t {
+  const PosDbHeader_t* header;
+  const PosDbEntry_t* entries;
+  size_t map_size;
+
+  PosDb_t() : header(NULL), entries(NULL), map_size(0) {}
+  ~PosDb_t() { close(); }
+  bool open(const char* _path);
+  void close();
+  size_t lower_bound(uint64_t _key) const;
+  uint32_t find(const Board64_t& _b, bool _white, std::vector<PosDbMove_t>& _moves) const;
+};
+
+inline
+bool PosDb_t::open(const char* _path) {
+  close();
+  int fd = ::open(_path, O_RDONLY);
+  if(fd < 0) return false;
+  struct stat st;
+  if(fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(PosDbHeader_t)) {
+    ::close(fd);
+    return false;
+  }
+  void* p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(p == MAP_FAILED) return false;
+  map_size = st.st_size;
+  header = (const PosDbHeader_t*)p;
+  entries = (const PosDbEntry_t*)(header+1);
+  if(memcmp(header->magic, POSDB_MAGIC, 8) != 0 ||
+     sizeof(PosDbHeader_t)+header->nb_entries*sizeof(PosDbEntry_t) > map_size) {
+    close();
+    return false;
+  }
+  return true;
+}
+inline
+void PosDb_t::close() {
+  if(header) munmap((void*)header, map_size);
+  header = NULL;
+  entries = NULL;
+  map_size = 0;
+}
+// première entrée de clé >= _key
+inline
+size_t PosDb_t::lower_bound(uint64_t _key) const {
+  size_t lo = 0;
+  size_t hi = header ? header->nb_entries : 0;
+  while(lo < hi) {
+    size_t mid = lo+(hi-lo)/2;
+    if(entries[mid].key < _key) lo = mid+1;
+    else hi = mid;
+  }
+  return lo;
+}
+// coups joués depuis _b (camp _white), remis dans l'orientation de _b ;
+// renvoie le nombre de parties passées par la position
+inline
+uint32_t PosDb_t::find(const Board64_t& _b, bool _white, std::vector<PosDbMove_t>& _moves) const {
+  _moves.clear();
+  if(!header) return 0;
+  bool mirrored = false;
+  uint64_t key = _b.canonical_hash(_white, &mirrored);
+  uint32_t total = 0;
+  for(size_t i = lower_bound(key); i < header->nb_entries && entries[i].key == key; i++) {
+    Move16_t m;
+    m.v = uint16_t(entries[i].move | (_white ? 0 : 0x200));
+    if(mirrored) m = m.mirror();
+    PosDbMove_t s;
+    s.move = _b.move16(m.from(), m.dir(), _white); // drapeau de prise de _b
+    s.games = entries[i].games;
+    s.wins = entries[i].wins;
+    total += s.games;
+    _moves.push_back(s);
+  }
+  return total;
+}
+
+// trie et regroupe les lignes d'une même (clé, coup) ; renvoie le nombre restant
+inline
+size_t posdb_aggregate(PosDbEntry_t* _e, size_t _nb) {
+  std::sort(_e, _e+_nb, posdb_entry_less);
+  size_t n = 0;
+  for(size_t i = 0; i < _nb; i++) {
+    if(n > 0 && posdb_same(_e[n-1], _e[i])) {
+      _e[n-1].games += _e[i].games;
+      _e[n-1].wins += _e[i].wins;
+    } else {
+      _e[n++] = _e[i];
+    }
+  }
+  return n;
+}
+
+#endif /* BKBB64_POSDB_H */
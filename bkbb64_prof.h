@@ -0,0 +1,191 @@
+// instrumentation des chemins critiques : compteurs par thread et temps par
+// phase mesurés au rdtsc. Compilé seulement avec -DBK_PROF (make PROF=1) ;
+// sinon les macros ne génèrent aucun code.
+#ifndef BKBB64_PROF_H
+#define BKBB64_PROF_H
+
+#include <cstdio>
+#include <cstdint>
+#include <inttypes.h>
+
+enum {
+  PROF_NODES = 0,
+  PROF_PLAYOUTS,
+  PROF_MOVEGEN,
+  PROF_TT_PROBES,
+  PROF_TT_HITS,
+  PROF_CUTOFFS,
+  PROF_EVALS,
+  PROF_NB_COUNTERS
+};
+
+// temps inclusifs : une phase compte aussi les phases appelées dedans
+enum {
+  PHASE_PARSE = 0,
+  PHASE_BOOK,
+  PHASE_PNS,
+  PHASE_SEARCH,
+  PHASE_QSEARCH,
+  PHASE_PLAYOUT,
+  PHASE_OUTPUT,
+  PHASE_NB
+};
+
+#ifdef BK_PROF
+
+static const bool PROF_ENABLED = true;
+
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static inline
+uint64_t prof_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// ticks par microseconde, mesurés une fois contre steady_clock (10 ms
+// d'attente active au premier résumé) : les temps par phase se comparent
+// d'une machine à l'autre. Sans rdtsc les ticks sont déjà des ns
+inline
+double prof_ticks_per_us() {
+#if defined(__x86_64__) || defined(__i386__)
+  static double rate = 0.0;
+  if(rate == 0.0) {
+    std::chrono::steady_clock::time_point c0 = std::chrono::steady_clock::now();
+    uint64_t t0 = prof_ticks();
+    std::chrono::steady_clock::time_point c1;
+    do {
+      c1 = std::chrono::steady_clock::now();
+    } while(c1-c0 < std::chrono::milliseconds(10));
+    uint64_t t1 = prof_ticks();
+    rate = double(t1-t0)/std::chrono::duration<double, std::micro>(c1-c0).count();
+  }
+  return rate;
+#else
+  return 1000.0;
+#endif
+}
+
+// bloc d'un thread, chaîné dans une liste globale et jamais libéré pour
+// que le résumé compte aussi les threads terminés
+struct ProfThread_t {
+  uint64_t counters[PROF_NB_COUNTERS];
+  uint64_t ticks[PHASE_NB];
+  uint64_t calls[PHASE_NB];
+  ProfThread_t* next;
+};
+
+struct ProfRegistry_t {
+  std::mutex lock;
+  ProfThread_t* head;
+};
+inline
+ProfRegistry_t& prof_registry() {
+  static ProfRegistry_t r;
+  return r;
+}
+inline
+ProfThread_t* prof_thread() {
+  static thread_local ProfThread_t* local = NULL;
+  if(!local) {
+    local = new ProfThread_t();
+    memset(local, 0, sizeof(ProfThread_t));
+    ProfRegistry_t& r = prof_registry();
+    std::lock_guard<std::mutex> g(r.lock);
+    local->next = r.head;
+    r.head = local;
+  }
+  return local;
+}
+
+struct ProfScope_t {
+  int phase;
+  uint64_t t0;
+  ProfScope_t(int _phase) : phase(_phase), t0(prof_ticks()) {}
+  ~ProfScope_t() {
+    ProfThread_t* t = prof_thread();
+    t->ticks[phase] += prof_ticks()-t0;
+    t->calls[phase]++;
+  }
+};
+
+inline
+void prof_reset() {
+  ProfRegistry_t& r = prof_registry();
+  std::lock_guard<std::mutex> g(r.lock);
+  for(ProfThread_t* t = r.head; t; t = t->next) {
+    memset(t->counters, 0, sizeof(t->counters));
+    memset(t->ticks, 0, sizeof(t->ticks));
+    memset(t->calls, 0, sizeof(t->calls));
+  }
+}
+
+// résumé de tous les threads depuis le dernier prof_reset
+inline
+void prof_dump(FILE* _out, bool _json, const char* _label) {
+  static const char* counter_names[PROF_NB_COUNTERS] = {
+    "nodes", "playouts", "movegen", "tt_probes", "tt_hits", "cutoffs", "evals"};
+  static const char* phase_names[PHASE_NB] = {
+    "parse", "book", "pns", "search", "qsearch", "playout", "output"};
+  uint64_t counters[PROF_NB_COUNTERS] = {0};
+  uint64_t ticks[PHASE_NB] = {0};
+  uint64_t calls[PHASE_NB] = {0};
+  int nb_threads = 0;
+  {
+    ProfRegistry_t& r = prof_registry();
+    std::lock_guard<std::mutex> g(r.lock);
+    for(ProfThread_t* t = r.head; t; t = t->next) {
+      nb_threads++;
+      for(int i = 0; i < PROF_NB_COUNTERS; i++) counters[i] += t->counters[i];
+      for(int i = 0; i < PHASE_NB; i++) { ticks[i] += t->ticks[i]; calls[i] += t->calls[i]; }
+    }
+  }
+  double per_us = prof_ticks_per_us();
+  if(_json) {
+    fprintf(_out, "{\"label\":\"%s\",\"threads\":%d,\"ticks_per_us\":%.1f", _label, nb_threads, per_us);
+    for(int i = 0; i < PROF_NB_COUNTERS; i++)
+      fprintf(_out, ",\"%s\":%" PRIu64, counter_names[i], counters[i]);
+    for(int i = 0; i < PHASE_NB; i++)
+      if(calls[i])
+        fprintf(_out, ",\"%s_ticks\":%" PRIu64 ",\"%s_us\":%.1f,\"%s_calls\":%" PRIu64,
+                phase_names[i], ticks[i], phase_names[i], ticks[i]/per_us, phase_names[i], calls[i]);
+    fprintf(_out, "}\n");
+  } else {
+    fprintf(_out, "prof %s (%d threads, %.1f ticks/us)\n", _label, nb_threads, per_us);
+    for(int i = 0; i < PROF_NB_COUNTERS; i++)
+      if(counters[i]) fprintf(_out, "  %-10s %14" PRIu64 "\n", counter_names[i], counters[i]);
+    for(int i = 0; i < PHASE_NB; i++)
+      if(calls[i])
+        fprintf(_out, "  %-10s %14" PRIu64 " ticks %12.3f ms %10" PRIu64 " calls %10.3f us/call\n", phase_names[i],
+                ticks[i], ticks[i]/per_us/1000.0, calls[i], ticks[i]/per_us/calls[i]);
+  }
+}
+
+#define BK_PROF_CAT2(a, b) a##b
+#define BK_PROF_CAT(a, b) BK_PROF_CAT2(a, b)
+#define BK_PROF_COUNT(c) (prof_thread()->counters[(c)]++)
+#define BK_PROF_ADD(c, n) (prof_thread()->counters[(c)] += (n))
+#define BK_PROF_SCOPE(p) ProfScope_t BK_PROF_CAT(prof_scope_, __LINE__)(p)
+
+#else
+
+static const bool PROF_ENABLED = false;
+
+#define BK_PROF_COUNT(c) ((void)0)
+#define BK_PROF_ADD(c, n) ((void)0)
+#define BK_PROF_SCOPE(p) ((void)0)
+inline void prof_reset() {}
+inline void prof_dump(FILE*, bool, const char*) {}
+
+#endif /* BK_PROF */
+
+#endif /* BKBB64_PROF_H */
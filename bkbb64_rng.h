@@ -0,0 +1,155 @@
+// générateurs pseudo-aléatoires des playouts : xoshiro256++ 64 bits,
+// flux indépendants par thread (saut de 2^128) et réduction d'intervalle
+// sans biais de Lemire (multiplication et décalage, pas de division)
+// https://prng.di.unimi.it/ et https://arxiv.org/abs/1805.10941
+#ifndef BKBB64_RNG_H
+#define BKBB64_RNG_H
+
+#include <cstdint>
+#include <cstddef>
+
+static inline
+uint64_t rotl64(uint64_t _x, int _k) {
+  return (_x<<_k) | (_x>>(64-_k));
+}
+
+// sert à initialiser les états : des graines proches donnent des états décorrélés
+static inline
+uint64_t splitmix64(uint64_t& _state) {
+  uint64_t z = (_state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z>>30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z>>27)) * 0x94d049bb133111ebULL;
+  return z ^ (z>>31);
+}
+
+// réduction de Lemire : _x 32 bits uniforme -> [0, _n) ; renvoie false
+// (rejet, tirer un autre _x) dans les rares cas qui introduiraient un biais
+static inline
+bool lemire_reduce(uint32_t _x, uint32_t _n, uint32_t& _r) {
+  uint64_t m = uint64_t(_x)*uint64_t(_n);
+  uint32_t l = uint32_t(m);
+  if(l < _n) {
+    uint32_t t = uint32_t(-_n) % _n; // seulement sur le chemin rare
+    if(l < t) return false;
+  }
+  _r = uint32_t(m>>32);
+  return true;
+}
+
+struct Rng64_t {
+  uint64_t s[4];
+
+  Rng64_t(uint64_t _seed = 1ULL) { seed(_seed); }
+  void seed(uint64_t _seed) {
+    uint64_t sm = _seed;
+    for(int i = 0; i < 4; i++) s[i] = splitmix64(sm);
+  }
+  uint64_t next() {
+    uint64_t r = rotl64(s[0]+s[3], 23)+s[0];
+    uint64_t t = s[1]<<17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return r;
+  }
+  // tirage uniforme dans [0, _n), _n > 0
+  uint32_t bounded(uint32_t _n) {
+    uint32_t r;
+    while(!lemire_reduce(uint32_t(next()>>32), _n, r)) {}
+    return r;
+  }
+  void jump();
+  Rng64_t split();
+};
+
+// avance de 2^128 tirages : flux disjoints pour chaque thread
+inline
+void Rng64_t::jump() {
+  static const uint64_t JUMP[4] = {
+    0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+    0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+  uint64_t t[4] = {0, 0, 0, 0};
+  for(int i = 0; i < 4; i++) {
+    for(int b = 0; b < 64; b++) {
+      if(JUMP[i] & (1ULL<<b))
+        for(int j = 0; j < 4; j++) t[j] ^= s[j];
+      next();
+    }
+  }
+  for(int j = 0; j < 4; j++) s[j] = t[j];
+}
+// renvoie le flux courant et passe au suivant
+inline
+Rng64_t Rng64_t::split() {
+  Rng64_t r = *this;
+  jump();
+  return r;
+}
+
+// RNG_LANES flux xoshiro256++ entrelacés (structure de tableaux) : la boucle
+// sur les voies est vectorisée par le compilateur (-O3)
+static const int RNG_LANES = 4;
+
+struct RngBatch_t {
+  uint64_t s0[RNG_LANES];
+  uint64_t s1[RNG_LANES];
+  uint64_t s2[RNG_LANES];
+  uint64_t s3[RNG_LANES];
+
+  RngBatch_t(uint64_t _seed = 1ULL) { seed(_seed); }
+  void seed(uint64_t _seed) {
+    Rng64_t r(_seed);
+    for(int l = 0; l < RNG_LANES; l++) {
+      Rng64_t lane = r.split();
+      s0[l] = lane.s[0];
+      s1[l] = lane.s[1];
+      s2[l] = lane.s[2];
+      s3[l] = lane.s[3];
+    }
+  }
+  void next(uint64_t* _out) {
+    for(int l = 0; l < RNG_LANES; l++) {
+      _out[l] = rotl64(s0[l]+s3[l], 23)+s0[l];
+      uint64_t t = s1[l]<<17;
+      s2[l] ^= s0[l];
+      s3[l] ^= s1[l];
+      s1[l] ^= s2[l];
+      s0[l] ^= s3[l];
+      s2[l] ^= t;
+      s3[l] = rotl64(s3[l], 45);
+    }
+  }
+  // _nb multiple de RNG_LANES
+  void fill(uint64_t* _out, size_t _nb) {
+    for(size_t i = 0; i < _nb; i += RNG_LANES) next(_out+i);
+  }
+};
+
+// tampon rempli par RngBatch_t, consommé 32 bits par 32 bits par les playouts
+struct RngBuffer_t {
+  static const int SIZE = 64;
+  RngBatch_t batch;
+  uint64_t buf[SIZE];
+  uint32_t pos; // en demi-mots
+
+  RngBuffer_t(uint64_t _seed = 1ULL) : batch(_seed), pos(2*SIZE) {}
+  uint32_t next32() {
+    if(pos == 2*SIZE) {
+      batch.fill(buf, SIZE);
+      pos = 0;
+    }
+    uint32_t r = uint32_t(buf[pos>>1]>>(32*(pos & 1)));
+    pos++;
+    return r;
+  }
+  uint32_t bounded(uint32_t _n) {
+    uint32_t r;
+    while(!lemire_reduce(next32(), _n, r)) {}
+    return r;
+  }
+};
+
+#endif /* BKBB64_RNG_H */
@@ -0,0 +1,769 @@
+// recherche alpha-beta sur bitboards pour breakthrough 8x8
+// avec table de transposition et ordonnancement des coups par étapes
+#ifndef BKBB64_SEARCH_H
+#define BKBB64_SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "bkbb64.h"
+#include "bkbb64_cache.h"
+#include "bkbb64_eval.h"
+#include "bkbb64_threat.h"
+#include "bkbb64_mem.h"
+
+static const int SCORE_WIN = 1000000;
+static const int SCORE_INF = 2000000;
+static const int MAX_PLY = 128;
+static const int MAX_MOVES = 64; // 16 pions * 3 directions suffisent
+
+// score de victoire au-delà duquel on est sur une victoire forcée
+static inline
+bool is_win_score(int _score) {
+  return _score > SCORE_WIN-MAX_PLY || _score < -SCORE_WIN+MAX_PLY;
+}
+
+// ligne du but et nombre de lignes parcourues depuis la ligne de départ
+static inline
+uint64_t goal_row(bool _white) {
+  return _white ? ROW_8 : ROW_1;
+}
+static inline
+int progress(int _sq, bool _white) {
+  return _white ? 7-(_sq>>3) : (_sq>>3);
+}
+
+// même barème que evaluer() : 100 par pion et 10 par ligne d'avance
+inline
+int eval_bb(const Board64_t& _b, bool _white) {
+  BK_PROF_COUNT(PROF_EVALS);
+  int score = 0;
+  for(int r = 0; r < 8; r++) {
+    uint64_t row = row_mask(r);
+    score += __builtin_popcountll(_b.white&row)*(100+10*(7-r));
+    score -= __builtin_popcountll(_b.black&row)*(100+10*r);
+  }
+  return _white ? score : -score;
+}
+
+// 8 octets par coup dans les listes
+struct ScoredMove64_t {
+  Move16_t move;
+  int32_t score;
+};
+
+struct MoveList64_t {
+  ScoredMove64_t moves[MAX_MOVES];
+  int size;
+
+  MoveList64_t() : size(0) {}
+  void add(const Move16_t& _m, int _score) {
+    moves[size].move = _m;
+    moves[size].score = _score;
+    size++;
+  }
+  // sélection du meilleur restant à partir de _from (tri paresseux)
+  const Move16_t& pick(int _from) {
+    int best = _from;
+    for(int i = _from+1; i < size; i++)
+      if(moves[i].score > moves[best].score) best = i;
+    if(best != _from) {
+      ScoredMove64_t tmp = moves[_from];
+      moves[_from] = moves[best];
+      moves[best] = tmp;
+    }
+    return moves[_from].move;
+  }
+};
+
+// ajoute les coups d'un masque de destinations dans la direction _dir,
+// _opp (pions adverses) donne le drapeau de prise
+static inline
+void add_moves_from_mask(MoveList64_t& _l, uint64_t _targets, int _dir, bool _white, uint64_t _opp) {
+  int delta = dir_delta(_dir, _white);
+  while(_targets) {
+    int to = __builtin_ctzll(_targets);
+    _l.add(Move16_t::make(to-delta, _dir, _white, (_opp>>to) & 1ULL), 0);
+    _targets &= _targets-1;
+  }
+}
+// coups de _lfr dont la destination est dans _targets
+static inline
+void add_lfr_moves(MoveList64_t& _l, const Lfr_t& _lfr, uint64_t _targets, bool _white, uint64_t _opp) {
+  add_moves_from_mask(_l, _lfr.forward & _targets, DIR_FORWARD, _white, _opp);
+  add_moves_from_mask(_l, _lfr.left & _targets, DIR_LEFT, _white, _opp);
+  add_moves_from_mask(_l, _lfr.right & _targets, DIR_RIGHT, _white, _opp);
+}
+// tous les coups du camp _white, sans ordre particulier
+inline
+void gen_moves(const Board64_t& _b, bool _white, MoveList64_t& _l) {
+  BK_PROF_COUNT(PROF_MOVEGEN);
+  _l.size = 0;
+  add_lfr_moves(_l, _b.lfr(_white), ~0ULL, _white, _white ? _b.black : _b.white);
+}
+
+// coup "tactique" : prise ou entrée sur la ligne du but
+inline
+bool is_tactical(const Move16_t& _m) {
+  return _m.capture() || (_m.to_mask() & goal_row(_m.white())) != 0ULL;
+}
+
+// étapes du sélecteur de coups
+enum {
+  STAGE_HASH = 0,
+  STAGE_GEN_CAPTURES,
+  STAGE_CAPTURES,
+  STAGE_KILLERS,
+  STAGE_GEN_QUIETS,
+  STAGE_QUIETS,
+  STAGE_DONE
+};
+
+// donne les coups dans l'ordre : coup de la table, prises (et entrées
+// sur la ligne du but), coups killers, puis coups calmes triés par historique ;
+// avec see, les prises perdantes passent après les autres ; construit vide
+// puis init() quand il vit dans une pile de tâche (bkbb64_task.h)
+struct MovePicker64_t {
+  const Board64_t* board;
+  bool white;
+  Move16_t hash_move;
+  Move16_t killers[2];
+  const int32_t (*history)[64];
+  bool use_see;
+  int stage;
+  int cur;
+  MoveList64_t list;
+
+  MovePicker64_t() : board(NULL), white(true), history(NULL), use_see(false), stage(STAGE_DONE), cur(0) {}
+  MovePicker64_t(const Board64_t& _b, bool _white, const Move16_t& _hash_move,
+                 const Move16_t* _killers, const int32_t (*_history)[64], bool _see = false) {
+    init(_b, _white, _hash_move, _killers, _history, _see);
+  }
+  void init(const Board64_t& _b, bool _white, const Move16_t& _hash_move,
+            const Move16_t* _killers, const int32_t (*_history)[64], bool _see = false);
+  bool next(Move16_t& _m);
+  bool skip(const Move16_t& _m) const;
+  void gen_captures();
+  void gen_quiets();
+};
+
+inline
+void MovePicker64_t::init(const Board64_t& _b, bool _white, const Move16_t& _hash_move,
+                          const Move16_t* _killers, const int32_t (*_history)[64], bool _see) {
+  board = &_b;
+  white = _white;
+  hash_move = _hash_move;
+  history = _history;
+  use_see = _see;
+  stage = STAGE_HASH;
+  cur = 0;
+  killers[0] = _killers ? _killers[0] : MOVE16_NONE;
+  killers[1] = _killers ? _killers[1] : MOVE16_NONE;
+}
+inline
+bool MovePicker64_t::skip(const Move16_t& _m) const {
+  return _m == hash_move || _m == killers[0] || _m == killers[1];
+}
+// prises classées selon l'avancée du pion qui prend ou du pion pris
+inline
+void MovePicker64_t::gen_captures() {
+  BK_PROF_COUNT(PROF_MOVEGEN);
+  list.size = 0;
+  uint64_t opp = white ? board->black : board->white;
+  uint64_t goal = goal_row(white);
+  add_lfr_moves(list, board->lfr(white), opp | goal, white, opp);
+  for(int i = 0; i < list.size; i++) {
+    const Move16_t& m = list.moves[i].move;
+    if(m.to_mask() & goal) {
+      list.moves[i].score = SCORE_WIN;
+      continue;
+    }
+    int sq = m.to();
+    int att = progress(sq, white);
+    int vic = progress(sq, !white);
+    list.moves[i].score = 16*(att > vic ? att : vic)+att+vic;
+    if(use_see) list.moves[i].score += 1024*see(*board, m);
+  }
+}
+// coups calmes classés par la table d'historique
+inline
+void MovePicker64_t::gen_quiets() {
+  BK_PROF_COUNT(PROF_MOVEGEN);
+  list.size = 0;
+  uint64_t opp = white ? board->black : board->white;
+  add_lfr_moves(list, board->lfr(white), ~(opp | goal_row(white)), white, opp);
+  for(int i = 0; i < list.size; i++) {
+    const Move16_t& m = list.moves[i].move;
+    list.moves[i].score = history ? history[m.from()][m.to()] : 0;
+  }
+}
+inline
+bool MovePicker64_t::next(Move16_t& _m) {
+  switch(stage) {
+  case STAGE_HASH:
+    stage = STAGE_GEN_CAPTURES;
+    if(hash_move.white() == white && board->is_legal(hash_move)) {
+      _m = hash_move;
+      return true;
+    }
+    hash_move = MOVE16_NONE;
+    // pas de break
+  case STAGE_GEN_CAPTURES:
+    gen_captures();
+    cur = 0;
+    stage = STAGE_CAPTURES;
+    // pas de break
+  case STAGE_CAPTURES:
+    while(cur < list.size) {
+      _m = list.pick(cur++);
+      if(_m != hash_move) return true;
+    }
+    stage = STAGE_KILLERS;
+    cur = 0;
+    // pas de break
+  case STAGE_KILLERS:
+    while(cur < 2) {
+      _m = killers[cur++];
+      if(_m.white() == white && _m != hash_move && board->is_legal(_m) && !is_tactical(_m))
+        return true;
+    }
+    stage = STAGE_GEN_QUIETS;
+    // pas de break
+  case STAGE_GEN_QUIETS:
+    gen_quiets();
+    cur = 0;
+    stage = STAGE_QUIETS;
+    // pas de break
+  case STAGE_QUIETS:
+    while(cur < list.size) {
+      _m = list.pick(cur++);
+      if(!skip(_m)) return true;
+    }
+    stage = STAGE_DONE;
+    // pas de break
+  default:
+    return false;
+  }
+}
+
+// table de transposition (remplacement par profondeur)
+enum { TT_EXACT = 0, TT_LOWER = 1, TT_UPPER = 2 };
+
+// 16 octets
+struct TTEntry64_t {
+  uint64_t key;
+  int32_t score;
+  Move16_t move;
+  int8_t depth;
+  uint8_t flag;
+};
+
+// la clé est stockée xorée avec les 8 octets de données : une entrée lue
+// pendant qu'un autre thread l'écrit (table partagée par le serveur) ne
+// passe pas la vérification de clé
+static inline
+uint64_t tt_data_word(const TTEntry64_t& _e) {
+  uint64_t d;
+  memcpy(&d, &_e.score, sizeof(d));
+  return d;
+}
+
+struct TT64_t {
+  LargeArray_t<TTEntry64_t> table; // pages de 2 Mo et numa selon mem_options, prises à la première écriture
+  uint64_t mask;
+
+  TT64_t(int _log2_size = 20) { resize(_log2_size); }
+  // table neuve, déjà vide
+  void resize(int _log2_size) {
+    table.reset(size_t(1)<<_log2_size);
+    mask = (uint64_t(1)<<_log2_size)-1;
+  }
+  void clear() {
+    table.zero();
+  }
+  bool probe(uint64_t _key, TTEntry64_t& _e) const {
+    TTEntry64_t e = table[_key & mask];
+    if((e.key ^ tt_data_word(e)) != _key) return false;
+    _e = e;
+    return true;
+  }
+  void store(uint64_t _key, const Move16_t& _m, int _score, int _depth, int _flag) {
+    TTEntry64_t& slot = table[_key & mask];
+    TTEntry64_t e = slot;
+    if((e.key ^ tt_data_word(e)) == _key && e.depth > _depth && _flag != TT_EXACT) return;
+    e.move = _m;
+    e.score = _score;
+    e.depth = int8_t(_depth);
+    e.flag = uint8_t(_flag);
+    e.key = _key ^ tt_data_word(e);
+    slot = e;
+  }
+};
+
+// les scores de victoire sont stockés relatifs au noeud et non à la racine
+static inline
+int score_to_tt(int _score, int _ply) {
+  if(_score > SCORE_WIN-MAX_PLY) return _score+_ply;
+  if(_score < -SCORE_WIN+MAX_PLY) return _score-_ply;
+  return _score;
+}
+static inline
+int score_from_tt(int _score, int _ply) {
+  if(_score > SCORE_WIN-MAX_PLY) return _score-_ply;
+  if(_score < -SCORE_WIN+MAX_PLY) return _score+_ply;
+  return _score;
+}
+
+// réglages de la recherche, chaque technique s'active séparément
+// (tout à false = alpha-beta simple)
+struct SearchOptions_t {
+  bool pvs;          // fenêtre nulle après le premier coup
+  bool aspiration;   // fenêtre d'aspiration à la racine
+  bool lmr;          // réduction des coups calmes tardifs
+  bool lmr_research; // nouvelle recherche si une réduction dépasse alpha
+  bool quiescence;   // prolonge les feuilles par les coups forcés
+  bool mirror_tt;    // une seule entrée pour une position et sa symétrique
+  bool pawn_eval;    // évaluation par structure de pions (bkbb64_eval.h)
+  bool see;          // échanges statiques : ordre des prises et réductions
+  int aspiration_delta;
+  int lmr_min_depth;
+  int lmr_min_moves;
+  int qs_max_ply;    // profondeur maximale de la quiescence
+  int qs_max_nodes;  // noeuds maximum par quiescence lancée depuis une feuille
+
+  SearchOptions_t() : pvs(false), aspiration(false), lmr(false), lmr_research(false), quiescence(false), mirror_tt(false),
+                      pawn_eval(false), see(false),
+                      aspiration_delta(50), lmr_min_depth(3), lmr_min_moves(3),
+                      qs_max_ply(12), qs_max_nodes(4096) {}
+  static SearchOptions_t all() {
+    SearchOptions_t o;
+    o.pvs = o.aspiration = o.lmr = o.lmr_research = o.quiescence = o.mirror_tt = true;
+    return o;
+  }
+};
+
+struct SearchStats_t {
+  uint64_t nodes;
+  uint64_t beta_cutoffs;
+  uint64_t first_move_cutoffs; // coupure dès le premier coup essayé
+  uint64_t tt_probes;
+  uint64_t tt_hits;
+  uint64_t reductions;
+  uint64_t researches;   // réduction ou fenêtre nulle à refaire
+  uint64_t aspiration_fails;
+  uint64_t qnodes;
+  uint64_t qs_aborts;    // quiescences arrêtées par la limite de noeuds
+  uint64_t evals;
+  uint64_t pawn_probes;  // cache de structure de pions (deux sondes par évaluation)
+  uint64_t pawn_hits;
+
+  SearchStats_t() { clear(); }
+  void clear() { memset(this, 0, sizeof(*this)); }
+  void print(FILE* _out) const {
+    fprintf(_out, "nodes %" PRIu64 " cutoffs %" PRIu64 " first %" PRIu64 " (%.1f%%) tt %" PRIu64 "/%" PRIu64 "\n",
+            nodes, beta_cutoffs, first_move_cutoffs,
+            beta_cutoffs ? 100.0*first_move_cutoffs/beta_cutoffs : 0.0,
+            tt_hits, tt_probes);
+    if(reductions || researches || aspiration_fails)
+      fprintf(_out, "reductions %" PRIu64 " researches %" PRIu64 " aspiration fails %" PRIu64 "\n",
+              reductions, researches, aspiration_fails);
+    if(qnodes)
+      fprintf(_out, "qnodes %" PRIu64 " (%.1f%%) qs aborts %" PRIu64 "\n",
+              qnodes, 100.0*qnodes/nodes, qs_aborts);
+    if(pawn_probes)
+      fprintf(_out, "evals %" PRIu64 " pawn cache %" PRIu64 "/%" PRIu64 " (%.1f%%)\n",
+              evals, pawn_hits, pawn_probes, 100.0*pawn_hits/pawn_probes);
+  }
+};
+
+struct SearchResult_t {
+  Move16_t move;
+  int score;
+  int depth;
+  uint64_t nodes;
+  double ms;
+};
+
+struct Search64_t {
+  SearchOptions_t opt;
+  TT64_t tt;
+  Move16_t killers[MAX_PLY][2];
+  int32_t history[2][64][64];
+  SearchStats_t stats;
+  PawnCache64_t pawns; // scores par camp de eval_pawns, propres à cette recherche
+  std::chrono::steady_clock::time_point start;
+  double time_limit_ms;
+  bool stop;
+  int qs_budget;
+  DiskCache_t* disk; // cache persistant optionnel, consulté après la table
+  TT64_t* shared_tt; // table commune à plusieurs recherches (NULL : tt)
+  const std::atomic<bool>* abort_flag; // arrêt demandé par un autre thread (NULL : aucun)
+
+  Search64_t(int _tt_log2_size = 20) : tt(_tt_log2_size), time_limit_ms(0.0), stop(false), qs_budget(0),
+                                       disk(NULL), shared_tt(NULL), abort_flag(NULL) {
+    clear_heuristics();
+  }
+  TT64_t& table() { return shared_tt ? *shared_tt : tt; }
+  void clear_heuristics() {
+    memset(killers, 0, sizeof(killers));
+    memset(history, 0, sizeof(history));
+  }
+  double elapsed_ms() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+  }
+  void check_time() {
+    if((stats.nodes & 1023) != 0) return;
+    if((time_limit_ms > 0.0 && elapsed_ms() > time_limit_ms) ||
+       (abort_flag && abort_flag->load(std::memory_order_relaxed)))
+      stop = true;
+  }
+  int evaluate(const Board64_t& _b, bool _white) {
+    stats.evals++;
+    if(!opt.pawn_eval) return eval_bb(_b, _white);
+    stats.pawn_probes += 2;
+    return eval_pawns(_b, _white, pawns, stats.pawn_hits);
+  }
+  void update_quiet(const Move16_t& _m, bool _white, int _depth, int _ply);
+  int reduction(const Move16_t& _m, int _nb_moves, int _depth, int _ply) const;
+  int search_move(const Board64_t& _b, bool _white, const Move16_t& _m, int _nb_moves,
+                  int _depth, int _alpha, int _beta, int _ply);
+  uint64_t tt_key(const Board64_t& _b, bool _white, bool& _mirrored) const {
+    if(opt.mirror_tt) return _b.canonical_hash(_white, &_mirrored);
+    _mirrored = false;
+    return _b.hash(_white);
+  }
+  bool probe(uint64_t _key, int _depth, TTEntry64_t& _e);
+  void store(uint64_t _key, const Move16_t& _m, int _score, int _depth, int _flag);
+  int qsearch(const Board64_t& _b, bool _white, int _alpha, int _beta, int _ply, int _qply);
+  int alphabeta(const Board64_t& _b, bool _white, int _depth, int _alpha, int _beta, int _ply);
+  int search_root(const Board64_t& _b, bool _white, int _depth, int _alpha, int _beta, Move16_t& _best);
+  void begin(double _time_ms, SearchResult_t& _res);
+  bool step(const Board64_t& _b, bool _white, int _depth, SearchResult_t& _res, FILE* _log = NULL);
+  void finish(const Board64_t& _b, bool _white, SearchResult_t& _res);
+  SearchResult_t think(const Board64_t& _b, bool _white, int _max_depth, double _time_ms, FILE* _log = NULL);
+};
+
+inline
+void Search64_t::update_quiet(const Move16_t& _m, bool _white, int _depth, int _ply) {
+  if(killers[_ply][0] != _m) {
+    killers[_ply][1] = killers[_ply][0];
+    killers[_ply][0] = _m;
+  }
+  int32_t& h = history[_white][_m.from()][_m.to()];
+  h += _depth*_depth;
+  if(h > (1<<24)) {
+    for(int i = 0; i < 64; i++)
+      for(int j = 0; j < 64; j++) history[_white][i][j] /= 2;
+  }
+}
+
+// table de transposition puis cache persistant, qui remplit la table
+inline
+bool Search64_t::probe(uint64_t _key, int _depth, TTEntry64_t& _e) {
+  stats.tt_probes++;
+  BK_PROF_COUNT(PROF_TT_PROBES);
+  if(table().probe(_key, _e)) {
+    stats.tt_hits++;
+    BK_PROF_COUNT(PROF_TT_HITS);
+    return true;
+  }
+  DiskCacheData_t d;
+  if(disk && _depth >= disk->min_depth && disk->probe(_key, d)) {
+    table().store(_key, d.move, d.score, d.depth, d.flag);
+    return table().probe(_key, _e);
+  }
+  return false;
+}
+inline
+void Search64_t::store(uint64_t _key, const Move16_t& _m, int _score, int _depth, int _flag) {
+  table().store(_key, _m, _score, _depth, _flag);
+  if(disk && _depth >= disk->min_depth && !_m.is_null()) {
+    DiskCacheData_t d;
+    d.score = _score;
+    d.depth = _depth;
+    d.flag = _flag;
+    d.move = _m;
+    disk->store(_key, d);
+  }
+}
+
+// réduction d'un coup tardif : seulement les coups calmes qui n'amènent
+// pas le pion à deux lignes ou moins du but
+inline
+int Search64_t::reduction(const Move16_t& _m, int _nb_moves, int _depth, int _ply) const {
+  if(!opt.lmr || _depth < opt.lmr_min_depth || _nb_moves <= opt.lmr_min_moves) return 0;
+  if(is_tactical(_m)) return 0;
+  if(_m == killers[_ply][0] || _m == killers[_ply][1]) return 0;
+  if(progress(_m.to(), _m.white()) >= 5) return 0;
+  return (_nb_moves > 8 && _depth > 5) ? 2 : 1;
+}
+
+// joue _m et cherche le fils ; le premier coup a la fenêtre complète,
+// les suivants une fenêtre nulle (pvs) et éventuellement une réduction
+inline
+int Search64_t::search_move(const Board64_t& _b, bool _white, const Move16_t& _m, int _nb_moves,
+                            int _depth, int _alpha, int _beta, int _ply) {
+  Board64_t child = _b;
+  child.apply_move(_m);
+  if(_nb_moves == 1) return -alphabeta(child, !_white, _depth-1, -_beta, -_alpha, _ply+1);
+  int r = reduction(_m, _nb_moves, _depth, _ply);
+  if(r > 0 && opt.see && _depth-1-r > 1 && see(_b, _m) < 0) r++; // le pion avancé est perdu
+  int lo = opt.pvs ? -_alpha-1 : -_beta;
+  if(r > 0) stats.reductions++;
+  int score = -alphabeta(child, !_white, _depth-1-r, lo, -_alpha, _ply+1);
+  if(r > 0 && score > _alpha && opt.lmr_research && !stop) {
+    stats.researches++;
+    score = -alphabeta(child, !_white, _depth-1, lo, -_alpha, _ply+1);
+  }
+  if(opt.pvs && score > _alpha && score < _beta && !stop) {
+    stats.researches++;
+    score = -alphabeta(child, !_white, _depth-1, -_beta, -_alpha, _ply+1);
+  }
+  return score;
+}
+
+// coups forcés pour la quiescence, pris directement dans les masques Lfr_t :
+// prises, et si l'adversaire a un pion à deux lignes de son but, les coups
+// qui occupent ou contrôlent les cases où il peut avancer
+inline
+void gen_qsearch_moves(const Board64_t& _b, bool _white, MoveList64_t& _l) {
+  BK_PROF_COUNT(PROF_MOVEGEN);
+  _l.size = 0;
+  uint64_t own = _white ? _b.white : _b.black;
+  uint64_t opp = _white ? _b.black : _b.white;
+  Lfr_t lfr = _b.lfr(_white);
+  add_lfr_moves(_l, lfr, opp, _white, opp);
+  uint64_t runners = opp & (_white ? row_mask(5) : row_mask(2));
+  if(runners) {
+    Board64_t r = _b;
+    if(_white) r.black = runners; else r.white = runners;
+    uint64_t reach = (r.forward(!_white) | r.left(!_white) | r.right(!_white)) & ~own;
+    // cases d'où un de nos pions prend sur une case atteinte par le coureur
+    uint64_t guard = _white ? (((reach & COL_NOT_H)<<9) | ((reach & COL_NOT_A)<<7))
+                            : (((reach & COL_NOT_A)>>9) | ((reach & COL_NOT_H)>>7));
+    add_lfr_moves(_l, lfr, (reach | guard) & ~opp, _white, opp);
+  }
+  for(int i = 0; i < _l.size; i++) {
+    int sq = _l.moves[i].move.to();
+    _l.moves[i].score = _l.moves[i].move.capture() ? 64+8*progress(sq, !_white) : progress(sq, _white);
+  }
+}
+
+// quiescence : prolonge une feuille par les prises et les parades forcées
+inline
+int Search64_t::qsearch(const Board64_t& _b, bool _white, int _alpha, int _beta, int _ply, int _qply) {
+  stats.nodes++;
+  BK_PROF_COUNT(PROF_NODES);
+  stats.qnodes++;
+  check_time();
+  if(stop) return 0;
+  if(_b.win(!_white)) return -(SCORE_WIN-_ply);
+  Lfr_t lfr = _b.lfr(_white);
+  uint64_t goal = goal_row(_white);
+  if((lfr.forward | lfr.left | lfr.right) & goal) return SCORE_WIN-_ply-1;
+
+  // un pion adverse sur notre avant-dernière ligne gagne si on ne le prend pas
+  uint64_t opp = _white ? _b.black : _b.white;
+  uint64_t threats = opp & (_white ? row_mask(6) : row_mask(1));
+  MoveList64_t l;
+  int best_score;
+  if(threats) {
+    add_lfr_moves(l, lfr, threats, _white, opp);
+    if(l.size == 0) return -(SCORE_WIN-_ply-2);
+    best_score = -SCORE_INF;
+  } else {
+    best_score = evaluate(_b, _white);
+    if(best_score >= _beta) return best_score;
+    if(best_score > _alpha) _alpha = best_score;
+    if(_qply >= opt.qs_max_ply || _ply >= MAX_PLY-1) return best_score;
+    if(qs_budget <= 0) {
+      stats.qs_aborts++;
+      return best_score;
+    }
+    gen_qsearch_moves(_b, _white, l);
+  }
+  qs_budget--;
+  for(int i = 0; i < l.size; i++) {
+    Board64_t child = _b;
+    child.apply_move(l.pick(i));
+    int score = -qsearch(child, !_white, -_beta, -_alpha, _ply+1, _qply+1);
+    if(stop) return 0;
+    if(score > best_score) best_score = score;
+    if(score > _alpha) _alpha = score;
+    if(_alpha >= _beta) {
+      BK_PROF_COUNT(PROF_CUTOFFS);
+      break;
+    }
+  }
+  return best_score;
+}
+
+// negamax alpha-beta, score du point de vue du camp _white
+inline
+int Search64_t::alphabeta(const Board64_t& _b, bool _white, int _depth, int _alpha, int _beta, int _ply) {
+  stats.nodes++;
+  BK_PROF_COUNT(PROF_NODES);
+  check_time();
+  if(stop) return 0;
+  if(_b.win(!_white)) return -(SCORE_WIN-_ply);
+  // un pion sur l'avant-dernière ligne qui peut avancer gagne au coup suivant
+  if((_b.forward(_white) | _b.left(_white) | _b.right(_white)) & goal_row(_white))
+    return SCORE_WIN-_ply-1;
+  if(_depth <= 0 || _ply >= MAX_PLY-1) {
+    if(!opt.quiescence) return evaluate(_b, _white);
+    BK_PROF_SCOPE(PHASE_QSEARCH);
+    qs_budget = opt.qs_max_nodes;
+    return qsearch(_b, _white, _alpha, _beta, _ply, 0);
+  }
+
+  bool mirrored;
+  uint64_t key = tt_key(_b, _white, mirrored);
+  Move16_t hash_move = MOVE16_NONE;
+  TTEntry64_t e;
+  if(probe(key, _depth, e)) {
+    hash_move = mirrored ? e.move.mirror() : e.move;
+    if(e.depth >= _depth) {
+      int s = score_from_tt(e.score, _ply);
+      if(e.flag == TT_EXACT) return s;
+      if(e.flag == TT_LOWER && s >= _beta) return s;
+      if(e.flag == TT_UPPER && s <= _alpha) return s;
+    }
+  }
+
+  int alpha0 = _alpha;
+  int best_score = -SCORE_INF;
+  Move16_t best = MOVE16_NONE;
+  int nb_moves = 0;
+  MovePicker64_t picker(_b, _white, hash_move, killers[_ply], history[_white], opt.see);
+  Move16_t m;
+  while(picker.next(m)) {
+    nb_moves++;
+    int score = search_move(_b, _white, m, nb_moves, _depth, _alpha, _beta, _ply);
+    if(stop) return 0;
+    if(score > best_score) {
+      best_score = score;
+      best = m;
+    }
+    if(score > _alpha) _alpha = score;
+    if(_alpha >= _beta) {
+      stats.beta_cutoffs++;
+      BK_PROF_COUNT(PROF_CUTOFFS);
+      if(nb_moves == 1) stats.first_move_cutoffs++;
+      if(!is_tactical(m)) update_quiet(m, _white, _depth, _ply);
+      break;
+    }
+  }
+  if(nb_moves == 0) return -(SCORE_WIN-_ply); // bloqué : perdu
+
+  int flag = best_score >= _beta ? TT_LOWER : (best_score > alpha0 ? TT_EXACT : TT_UPPER);
+  store(key, mirrored ? best.mirror() : best, score_to_tt(best_score, _ply), _depth, flag);
+  return best_score;
+}
+
+inline
+int Search64_t::search_root(const Board64_t& _b, bool _white, int _depth, int _alpha, int _beta, Move16_t& _best) {
+  int alpha0 = _alpha;
+  int best_score = -SCORE_INF;
+  int nb_moves = 0;
+  MovePicker64_t picker(_b, _white, _best, killers[0], history[_white], opt.see);
+  Move16_t m;
+  stats.nodes++;
+  BK_PROF_COUNT(PROF_NODES);
+  while(picker.next(m)) {
+    nb_moves++;
+    int score = search_move(_b, _white, m, nb_moves, _depth, _alpha, _beta, 0);
+    if(stop) break;
+    if(score > best_score) {
+      best_score = score;
+      _best = m;
+    }
+    if(score > _alpha) _alpha = score;
+    if(_alpha >= _beta) {
+      stats.beta_cutoffs++;
+      BK_PROF_COUNT(PROF_CUTOFFS);
+      if(nb_moves == 1) stats.first_move_cutoffs++;
+      break;
+    }
+  }
+  if(!stop && !_best.is_null() && best_score > alpha0 && best_score < _beta) {
+    bool mirrored;
+    uint64_t key = tt_key(_b, _white, mirrored);
+    store(key, mirrored ? _best.mirror() : _best, best_score, _depth, TT_EXACT);
+  }
+  return best_score;
+}
+
+// approfondissement itératif découpé en étapes (une profondeur chacune)
+// pour que le serveur puisse intercaler les recherches de plusieurs parties
+inline
+void Search64_t::begin(double _time_ms, SearchResult_t& _res) {
+  _res.move = MOVE16_NONE;
+  _res.score = 0;
+  _res.depth = 0;
+  _res.nodes = 0;
+  _res.ms = 0.0;
+  stats.clear();
+  start = std::chrono::steady_clock::now();
+  time_limit_ms = _time_ms;
+  stop = false;
+}
+
+// recherche à la profondeur _depth ; false quand il ne faut pas continuer
+inline
+bool Search64_t::step(const Board64_t& _b, bool _white, int _depth, SearchResult_t& _res, FILE* _log) {
+  BK_PROF_SCOPE(PHASE_SEARCH);
+  Move16_t best = _res.move;
+  int score;
+  if(opt.aspiration && _depth >= 3 && !is_win_score(_res.score)) {
+    // fenêtre autour du score précédent, élargie à chaque échec
+    int delta = opt.aspiration_delta;
+    while(1) {
+      int alpha = _res.score-delta;
+      int beta = _res.score+delta;
+      score = search_root(_b, _white, _depth, alpha, beta, best);
+      if(stop || (score > alpha && score < beta)) break;
+      stats.aspiration_fails++;
+      if(delta >= SCORE_WIN) {
+        score = search_root(_b, _white, _depth, -SCORE_INF, SCORE_INF, best);
+        break;
+      }
+      delta *= 4;
+    }
+  } else {
+    score = search_root(_b, _white, _depth, -SCORE_INF, SCORE_INF, best);
+  }
+  if(stop && _depth > 1) return false;
+  _res.move = best;
+  _res.score = score;
+  _res.depth = _depth;
+  if(_log) {
+    fprintf(_log, "depth %d score %d move %s ms %.1f ", _depth, score,
+            best.to_str().c_str(), elapsed_ms());
+    stats.print(_log);
+  }
+  return !stop && !is_win_score(score);
+}
+
+inline
+void Search64_t::finish(const Board64_t& _b, bool _white, SearchResult_t& _res) {
+  if(_res.move.is_null()) { // temps écoulé avant la fin de la profondeur 1
+    MoveList64_t l;
+    gen_moves(_b, _white, l);
+    if(l.size) _res.move = l.moves[0].move;
+  }
+  _res.nodes = stats.nodes;
+  _res.ms = elapsed_ms();
+}
+
+// approfondissement itératif jusqu'à _max_depth ou _time_ms millisecondes
+inline
+SearchResult_t Search64_t::think(const Board64_t& _b, bool _white, int _max_depth, double _time_ms, FILE* _log) {
+  SearchResult_t res;
+  begin(_time_ms, res);
+  for(int depth = 1; depth <= _max_depth; depth++)
+    if(!step(_b, _white, depth, res, _log)) break;
+  finish(_b, _white, res);
+  return res;
+}
+
+#endif /* BKBB64_SEARCH_H */
@@ -0,0 +1,386 @@
+// recherches reprenables : une tâche avance d'un nombre borné de noeuds
+// (alpha-beta) ou de simulations (mcts) par pas puis rend la main, tout son
+// état est sur le tas. Un ordonnanceur peut ainsi faire avancer des
+// centaines de parties sur quelques threads avec une latence par pas
+// prévisible (Search64_t::step fait toute une profondeur, de durée non
+// bornée). C++11 : pas de coroutines, l'alpha-beta est une machine à états
+// sur une pile explicite de cadres qui déroule exactement les mêmes appels
+// que Search64_t::think (mêmes noeuds, même résultat), avec la table, les
+// killers, l'historique et les statistiques de la Search64_t associée. Les
+// feuilles et leur quiescence restent récursives (Search64_t::alphabeta à
+// profondeur 0, au plus qs_max_nodes noeuds) : un pas peut dépasser son
+// budget d'autant, mais la pile de cadres ne coûte plus qu'aux noeuds
+// intérieurs.
+#ifndef BKBB64_TASK_H
+#define BKBB64_TASK_H
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include "bkbb64_search.h"
+#include "bkbb64_mcts.h"
+
+// sortes de cadres : racine (search_root), noeud intérieur (alphabeta)
+enum { FRAME_ROOT = 0, FRAME_AB };
+
+// points de reprise d'un cadre
+enum {
+  PC_ENTER = 0,
+  PC_NEXT,     // coup suivant
+  PC_REDUCED,  // retour de la recherche réduite ou en fenêtre nulle
+  PC_VERIFY,   // retour de la vérification sans réduction
+  PC_SCORE     // retour de la dernière recherche du coup
+};
+
+// un appel de alphabeta ou search_root suspendu
+struct TaskFrame64_t {
+  int kind;
+  int pc;
+  Board64_t b;
+  bool white;
+  bool mirrored;
+  int depth;
+  int alpha;
+  int beta;
+  int ply;
+  int alpha0;
+  int best_score;
+  int nb_moves;
+  int r;      // réduction du coup en cours
+  int lo;     // borne basse de sa fenêtre nulle
+  int score;
+  uint64_t key;
+  Move16_t best;
+  Move16_t m;
+  Board64_t child;
+  MovePicker64_t picker; // garde un pointeur sur b : les cadres ne bougent pas (deque)
+};
+
+// états de la tâche entre deux cadres racine
+enum { TASK_DONE = 0, TASK_DEPTH, TASK_ROOT };
+
+// approfondissement itératif de Search64_t::think en pas de noeuds bornés
+struct AbTask64_t {
+  Search64_t& s;
+  Board64_t board;
+  bool white;
+  int max_depth;
+  FILE* log;
+  SearchResult_t res;
+  int state;
+  int depth;       // profondeur en cours
+  bool aspiration; // fenêtre d'aspiration de la racine en cours
+  int delta;
+  int alpha;
+  int beta;
+  Move16_t best;
+  std::deque<TaskFrame64_t> frames; // ne grandit que jusqu'à la plus grande profondeur atteinte
+  int top;         // cadre en cours (-1 : pile vide)
+  int ret;         // score rendu par le dernier cadre dépilé
+
+  explicit AbTask64_t(Search64_t& _s) : s(_s), white(true), max_depth(0), log(NULL), state(TASK_DONE), depth(0),
+                                         aspiration(false), delta(0), alpha(0), beta(0), top(-1), ret(0) {
+    res = SearchResult_t();
+  }
+  void start(const Board64_t& _b, bool _white, int _max_depth, double _time_ms, FILE* _log = NULL);
+  bool step(uint64_t _max_nodes, double _max_ms = 0.0);
+  bool done() const { return state == TASK_DONE; }
+  void run_frame();
+  void call(int _kind, const Board64_t& _b, bool _white, int _depth, int _alpha, int _beta, int _ply);
+  void leave(int _score) { top--; ret = _score; }
+  void search_child(TaskFrame64_t& _f);
+  void full_window(TaskFrame64_t& _f);
+  void enter_ab(TaskFrame64_t& _f);
+  void move_done(TaskFrame64_t& _f);
+  void end_node(TaskFrame64_t& _f);
+  void begin_root();
+  void end_root();
+};
+
+inline
+void AbTask64_t::start(const Board64_t& _b, bool _white, int _max_depth, double _time_ms, FILE* _log) {
+  board = _b;
+  white = _white;
+  max_depth = _max_depth;
+  log = _log;
+  s.begin(_time_ms, res);
+  depth = 1;
+  top = -1;
+  state = _max_depth >= 1 ? TASK_DEPTH : TASK_DONE;
+  if(state == TASK_DONE) s.finish(board, white, res);
+}
+
+// avance d'au plus _max_nodes noeuds (0 : sans limite) et _max_ms
+// millisecondes (0 : sans limite, vérifié tous les 1024 noeuds comme
+// check_time) ; true s'il reste du travail
+inline
+bool AbTask64_t::step(uint64_t _max_nodes, double _max_ms) {
+  BK_PROF_SCOPE(PHASE_SEARCH);
+  uint64_t limit = _max_nodes ? s.stats.nodes+_max_nodes : ~0ULL;
+  std::chrono::steady_clock::time_point t0;
+  if(_max_ms > 0.0) t0 = std::chrono::steady_clock::now();
+  uint64_t last = s.stats.nodes;
+  while(state != TASK_DONE) {
+    if(s.stats.nodes >= limit) return true;
+    if(_max_ms > 0.0 && (s.stats.nodes>>10) != (last>>10)) {
+      last = s.stats.nodes;
+      if(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t0).count() > _max_ms)
+        return true;
+    }
+    if(top >= 0) run_frame();
+    else if(state == TASK_DEPTH) begin_root();
+    else end_root();
+  }
+  return false;
+}
+
+// empile un appel ; le cadre appelant reprend à son pc quand il est dépilé,
+// tout de suite pour une feuille cherchée d'un bloc
+inline
+void AbTask64_t::call(int _kind, const Board64_t& _b, bool _white, int _depth, int _alpha, int _beta, int _ply) {
+  if(_kind == FRAME_AB && (_depth <= 0 || _ply >= MAX_PLY-1)) {
+    ret = s.alphabeta(_b, _white, _depth, _alpha, _beta, _ply);
+    return;
+  }
+  top++;
+  if(top >= int(frames.size())) frames.resize(top+1);
+  TaskFrame64_t& f = frames[top];
+  f.kind = _kind;
+  f.pc = PC_ENTER;
+  f.b = _b;
+  f.white = _white;
+  f.depth = _depth;
+  f.alpha = _alpha;
+  f.beta = _beta;
+  f.ply = _ply;
+}
+
+// fenêtre d'aspiration puis cadre racine de la profondeur en cours
+inline
+void AbTask64_t::begin_root() {
+  best = res.move;
+  aspiration = s.opt.aspiration && depth >= 3 && !is_win_score(res.score);
+  if(aspiration) {
+    delta = s.opt.aspiration_delta;
+    alpha = res.score-delta;
+    beta = res.score+delta;
+  } else {
+    alpha = -SCORE_INF;
+    beta = SCORE_INF;
+  }
+  state = TASK_ROOT;
+  call(FRAME_ROOT, board, white, depth, alpha, beta, 0);
+}
+
+// retour de la racine : fenêtre élargie, ou fin de la profondeur (Search64_t::step)
+inline
+void AbTask64_t::end_root() {
+  int score = ret;
+  if(aspiration && !s.stop && (score <= alpha || score >= beta)) {
+    s.stats.aspiration_fails++;
+    if(delta >= SCORE_WIN) {
+      aspiration = false;
+      call(FRAME_ROOT, board, white, depth, -SCORE_INF, SCORE_INF, 0);
+      return;
+    }
+    delta *= 4;
+    alpha = res.score-delta;
+    beta = res.score+delta;
+    call(FRAME_ROOT, board, white, depth, alpha, beta, 0);
+    return;
+  }
+  if(s.stop && depth > 1) {
+    state = TASK_DONE;
+    s.finish(board, white, res);
+    return;
+  }
+  res.move = best;
+  res.score = score;
+  res.depth = depth;
+  if(log) {
+    fprintf(log, "depth %d score %d move %s ms %.1f ", depth, score, best.to_str().c_str(), s.elapsed_ms());
+    s.stats.print(log);
+  }
+  if(s.stop || is_win_score(score) || ++depth > max_depth) {
+    state = TASK_DONE;
+    s.finish(board, white, res);
+  } else {
+    state = TASK_DEPTH;
+  }
+}
+
+// début de alphabeta (noeud intérieur) ; dépilé aussitôt sans coup à chercher
+inline
+void AbTask64_t::enter_ab(TaskFrame64_t& _f) {
+  s.stats.nodes++;
+  BK_PROF_COUNT(PROF_NODES);
+  s.check_time();
+  if(s.stop) return leave(0);
+  if(_f.b.win(!_f.white)) return leave(-(SCORE_WIN-_f.ply));
+  if((_f.b.forward(_f.white) | _f.b.left(_f.white) | _f.b.right(_f.white)) & goal_row(_f.white))
+    return leave(SCORE_WIN-_f.ply-1);
+  _f.key = s.tt_key(_f.b, _f.white, _f.mirrored);
+  Move16_t hash_move = MOVE16_NONE;
+  TTEntry64_t e;
+  if(s.probe(_f.key, _f.depth, e)) {
+    hash_move = _f.mirrored ? e.move.mirror() : e.move;
+    if(e.depth >= _f.depth) {
+      int sc = score_from_tt(e.score, _f.ply);
+      if(e.flag == TT_EXACT) return leave(sc);
+      if(e.flag == TT_LOWER && sc >= _f.beta) return leave(sc);
+      if(e.flag == TT_UPPER && sc <= _f.alpha) return leave(sc);
+    }
+  }
+  _f.alpha0 = _f.alpha;
+  _f.best_score = -SCORE_INF;
+  _f.best = MOVE16_NONE;
+  _f.nb_moves = 0;
+  _f.picker.init(_f.b, _f.white, hash_move, s.killers[_f.ply], s.history[_f.white], s.opt.see);
+  _f.pc = PC_NEXT;
+}
+
+// Search64_t::search_move en étapes : chaque recherche du fils est un appel
+inline
+void AbTask64_t::search_child(TaskFrame64_t& _f) {
+  _f.child = _f.b;
+  _f.child.apply_move(_f.m);
+  int ply = _f.ply+1;
+  if(_f.nb_moves == 1) {
+    _f.pc = PC_SCORE;
+    return call(FRAME_AB, _f.child, !_f.white, _f.depth-1, -_f.beta, -_f.alpha, ply);
+  }
+  _f.r = s.reduction(_f.m, _f.nb_moves, _f.depth, _f.ply);
+  if(_f.r > 0 && s.opt.see && _f.depth-1-_f.r > 1 && see(_f.b, _f.m) < 0) _f.r++;
+  _f.lo = s.opt.pvs ? -_f.alpha-1 : -_f.beta;
+  if(_f.r > 0) s.stats.reductions++;
+  _f.pc = PC_REDUCED;
+  call(FRAME_AB, _f.child, !_f.white, _f.depth-1-_f.r, _f.lo, -_f.alpha, ply);
+}
+
+// fenêtre nulle qui tombe dans (alpha, beta) : refaite en fenêtre complète (pvs)
+inline
+void AbTask64_t::full_window(TaskFrame64_t& _f) {
+  if(s.opt.pvs && _f.score > _f.alpha && _f.score < _f.beta && !s.stop) {
+    s.stats.researches++;
+    _f.pc = PC_SCORE;
+    return call(FRAME_AB, _f.child, !_f.white, _f.depth-1, -_f.beta, -_f.alpha, _f.ply+1);
+  }
+  move_done(_f);
+}
+
+// score du coup _f.m connu : meilleur coup, fenêtre, coupure
+inline
+void AbTask64_t::move_done(TaskFrame64_t& _f) {
+  bool root = _f.kind == FRAME_ROOT;
+  if(s.stop) {
+    if(root) return end_node(_f);
+    return leave(0);
+  }
+  if(_f.score > _f.best_score) {
+    _f.best_score = _f.score;
+    _f.best = _f.m;
+  }
+  if(_f.score > _f.alpha) _f.alpha = _f.score;
+  if(_f.alpha >= _f.beta) {
+    s.stats.beta_cutoffs++;
+    BK_PROF_COUNT(PROF_CUTOFFS);
+    if(_f.nb_moves == 1) s.stats.first_move_cutoffs++;
+    if(!root && !is_tactical(_f.m)) s.update_quiet(_f.m, _f.white, _f.depth, _f.ply);
+    return end_node(_f);
+  }
+  _f.pc = PC_NEXT;
+}
+
+// fin de alphabeta ou de search_root
+inline
+void AbTask64_t::end_node(TaskFrame64_t& _f) {
+  if(_f.kind == FRAME_ROOT) {
+    if(!_f.best.is_null()) best = _f.best;
+    if(!s.stop && !best.is_null() && _f.best_score > _f.alpha0 && _f.best_score < _f.beta) {
+      bool mirrored;
+      uint64_t key = s.tt_key(_f.b, _f.white, mirrored);
+      s.store(key, mirrored ? best.mirror() : best, _f.best_score, _f.depth, TT_EXACT);
+    }
+    return leave(_f.best_score);
+  }
+  if(_f.nb_moves == 0) return leave(-(SCORE_WIN-_f.ply));
+  int flag = _f.best_score >= _f.beta ? TT_LOWER : (_f.best_score > _f.alpha0 ? TT_EXACT : TT_UPPER);
+  s.store(_f.key, _f.mirrored ? _f.best.mirror() : _f.best, score_to_tt(_f.best_score, _f.ply), _f.depth, flag);
+  leave(_f.best_score);
+}
+
+// une transition du cadre du sommet
+inline
+void AbTask64_t::run_frame() {
+  TaskFrame64_t& f = frames[top];
+  switch(f.pc) {
+  case PC_ENTER:
+    if(f.kind == FRAME_AB) return enter_ab(f);
+    // racine : ni table ni test de fin, le meilleur coup précédent d'abord
+    f.alpha0 = f.alpha;
+    f.best_score = -SCORE_INF;
+    f.best = MOVE16_NONE;
+    f.nb_moves = 0;
+    f.picker.init(f.b, f.white, best, s.killers[0], s.history[f.white], s.opt.see);
+    s.stats.nodes++;
+    BK_PROF_COUNT(PROF_NODES);
+    f.pc = PC_NEXT;
+    return;
+  case PC_NEXT:
+    if(!f.picker.next(f.m)) return end_node(f);
+    f.nb_moves++;
+    return search_child(f);
+  case PC_REDUCED:
+    f.score = -ret;
+    if(f.r > 0 && f.score > f.alpha && s.opt.lmr_research && !s.stop) {
+      s.stats.researches++;
+      f.pc = PC_VERIFY;
+      return call(FRAME_AB, f.child, !f.white, f.depth-1, f.lo, -f.alpha, f.ply+1);
+    }
+    return full_window(f);
+  case PC_VERIFY:
+    f.score = -ret;
+    return full_window(f);
+  case PC_SCORE:
+    f.score = -ret;
+    return move_done(f);
+  }
+}
+
+// mcts par pas de simulations : l'arbre est déjà sur le tas et
+// Mcts64_t::run reprend où il s'est arrêté
+struct MctsTask64_t {
+  Mcts64_t& tree;
+  uint64_t max_iter;  // 0 : sans limite
+  double time_ms;     // 0 : sans limite
+  std::chrono::steady_clock::time_point begin;
+
+  explicit MctsTask64_t(Mcts64_t& _tree) : tree(_tree), max_iter(0), time_ms(0.0) {}
+  void start(const Board64_t& _b, bool _white, double _time_ms, uint64_t _max_iter = 0) {
+    tree.reset(_b, _white);
+    time_ms = _time_ms;
+    max_iter = _max_iter;
+    begin = std::chrono::steady_clock::now();
+  }
+  double elapsed_ms() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-begin).count();
+  }
+  bool done() const {
+    return (max_iter && tree.iterations >= max_iter) || (time_ms > 0.0 && elapsed_ms() > time_ms);
+  }
+  // au plus _playouts simulations ; true s'il reste du travail
+  bool step(uint64_t _playouts) {
+    if(done()) return false;
+    uint64_t end = tree.iterations+_playouts;
+    if(max_iter && end > max_iter) end = max_iter;
+    tree.run(0.0, end);
+    return !done();
+  }
+  MctsResult_t result() const {
+    MctsResult_t r = tree.result();
+    r.ms = elapsed_ms();
+    return r;
+  }
+};
+
+#endif /* BKBB64_TASK_H */
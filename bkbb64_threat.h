@@ -0,0 +1,87 @@
+// cartes de menaces et évaluation statique des échanges (see) : un pion
+// n'attaque (et ne défend) que les deux cases en diagonale devant lui, deux
+// décalages par camp comme white_left/white_right suffisent. Pas de pièce
+// à longue portée, donc pas de rayons X : les attaquants d'une case ne
+// changent pas pendant un échange, qui se résout en comptant les
+// attaquants de chaque camp.
+#ifndef BKBB64_THREAT_H
+#define BKBB64_THREAT_H
+
+#include "bkbb64.h"
+
+// cases attaquées par les pions _p du camp _white, vers la colonne A et
+// vers la colonne H
+static inline
+uint64_t attacks_left(uint64_t _p, bool _white) {
+  return _white ? (_p & COL_NOT_A)>>Geom8_t::DIAG_A_WHITE : (_p & COL_NOT_A)<<Geom8_t::DIAG_A_BLACK;
+}
+static inline
+uint64_t attacks_right(uint64_t _p, bool _white) {
+  return _white ? (_p & COL_NOT_H)>>Geom8_t::DIAG_H_WHITE : (_p & COL_NOT_H)<<Geom8_t::DIAG_H_BLACK;
+}
+static inline
+uint64_t pawn_attacks(uint64_t _p, bool _white) {
+  return attacks_left(_p, _white) | attacks_right(_p, _white);
+}
+// pions de _p (camp _white) qui attaquent une des cases _sq
+static inline
+uint64_t pawn_attackers(uint64_t _p, uint64_t _sq, bool _white) {
+  if(_white) return _p & (((_sq & COL_NOT_H)<<Geom8_t::DIAG_A_WHITE) | ((_sq & COL_NOT_A)<<Geom8_t::DIAG_H_WHITE));
+  return _p & (((_sq & COL_NOT_H)>>Geom8_t::DIAG_A_BLACK) | ((_sq & COL_NOT_A)>>Geom8_t::DIAG_H_BLACK));
+}
+
+// cartes des deux camps (indice 1 : blancs) : cases attaquées au moins une
+// fois et deux fois ; une case attaquée l'est aussi bien pour prendre que
+// pour défendre un pion ami qui s'y trouve
+struct Threats64_t {
+  uint64_t once[2];
+  uint64_t twice[2];
+
+  explicit Threats64_t(const Board64_t& _b) {
+    for(int s = 0; s < 2; s++) {
+      uint64_t p = s ? _b.white : _b.black;
+      uint64_t l = attacks_left(p, s != 0);
+      uint64_t r = attacks_right(p, s != 0);
+      once[s] = l | r;
+      twice[s] = l & r;
+    }
+  }
+  // plus d'attaquants adverses que de défenseurs (le pion pris ne défend pas)
+  uint64_t outnumbered(bool _white) const {
+    return (once[!_white] & ~once[_white]) | (twice[!_white] & ~twice[_white]);
+  }
+  // pions de _p (camp _white) attaqués et non défendus
+  uint64_t hanging(uint64_t _p, bool _white) const {
+    return _p & once[!_white] & ~once[_white];
+  }
+};
+
+// bilan en pions, pour le camp qui joue _m, de l'échange sur la case
+// d'arrivée : chaque camp prend tant que c'est à son avantage et peut
+// s'arrêter. Un coup calme vaut 0 s'il est sûr, -1 si le pion est perdu
+inline
+int see(const Board64_t& _b, const Move16_t& _m) {
+  bool white = _m.white();
+  uint64_t to = _m.to_mask();
+  uint64_t own = (white ? _b.white : _b.black) & ~_m.from_mask();
+  int nb[2];
+  nb[0] = int(count64(pawn_attackers(white ? _b.black : _b.white, to, !white))); // reprises adverses
+  nb[1] = int(count64(pawn_attackers(own, to, white)));
+  int gain[6];
+  int d = 0;
+  gain[0] = _m.capture() ? 1 : 0;
+  // le camp au trait sur la case (0 : adversaire) reprend le pion qui s'y trouve
+  for(int side = 0; nb[side] > 0 && d < 5; side ^= 1) {
+    nb[side]--;
+    d++;
+    gain[d] = 1-gain[d-1];
+  }
+  // en remontant : un camp ne prend que si c'est mieux que de s'arrêter
+  while(d > 0) {
+    d--;
+    if(-gain[d+1] < gain[d]) gain[d] = -gain[d+1];
+  }
+  return gain[0];
+}
+
+#endif /* BKBB64_THREAT_H */
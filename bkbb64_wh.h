@@ -0,0 +1,250 @@
+// breakthrough W x H (64 cases au plus) sur bitboards, géométrie fixée à la
+// compilation (bkbb64_geom.h) : génération des coups, playouts, perft et
+// recherche alpha-beta pour les variantes 5x5, 6x6, 7x7... utilisées pour
+// tester et résoudre vite. Les masques et décalages sont des constantes de
+// BoardWH_t<8, 8> comme de Board64_t, le débit par coup ne dépend pas de la
+// taille. Les coups sont des Move64_t (masques) comme pour Board64_t.
+#ifndef BKBB64_WH_H
+#define BKBB64_WH_H
+
+#include <chrono>
+#include "bkbb64.h"
+
+template<int W, int H>
+struct BoardWH_t {
+  typedef Geom_t<W, H> G;
+  uint64_t white;
+  uint64_t black;
+
+  BoardWH_t() : white(G::WHITE_START), black(G::BLACK_START) {}
+  bool operator== (const BoardWH_t& _o) const { return white == _o.white && black == _o.black; }
+
+  uint64_t empty() const { return ~(white | black) & G::BOARD; }
+  uint64_t forward(bool _white) const;
+  uint64_t left(bool _white) const;
+  uint64_t right(bool _white) const;
+  Lfr_t lfr(bool _white) const { return Lfr_t(left(_white), forward(_white), right(_white)); }
+  uint32_t win(bool _white) const;
+  Move64_t nth_move(const Lfr_t& _lfr, uint32_t _n, bool _white) const;
+  void apply_move(const Move64_t& _m, bool _white);
+  int eval(bool _white) const;
+  template<class Rng> bool seq_playout(bool _white, Rng& _rng);
+  uint64_t perft(int _depth, bool _white) const;
+  void print_board(FILE* _out = stdout) const;
+};
+
+typedef BoardWH_t<5, 5> Board55_t;
+typedef BoardWH_t<6, 6> Board66_t;
+typedef BoardWH_t<7, 7> Board77_t;
+typedef BoardWH_t<8, 8> Board88_t;
+
+// cases d'arrivée de chaque direction (gauche = vers la colonne A)
+template<int W, int H>
+inline
+uint64_t BoardWH_t<W, H>::forward(bool _white) const {
+  if(_white) return (white>>G::FORWARD) & empty();
+  return (black<<G::FORWARD) & empty();
+}
+template<int W, int H>
+inline
+uint64_t BoardWH_t<W, H>::left(bool _white) const {
+  if(_white) return ((white & G::NOT_COL_A)>>G::DIAG_A_WHITE) & ~white;
+  return ((black & G::NOT_COL_A)<<G::DIAG_A_BLACK) & ~black & G::BOARD;
+}
+template<int W, int H>
+inline
+uint64_t BoardWH_t<W, H>::right(bool _white) const {
+  if(_white) return ((white & G::NOT_COL_LAST)>>G::DIAG_H_WHITE) & ~white;
+  return ((black & G::NOT_COL_LAST)<<G::DIAG_H_BLACK) & ~black & G::BOARD;
+}
+// _white a gagné : un pion sur la ligne du but ou plus de pion adverse
+template<int W, int H>
+inline
+uint32_t BoardWH_t<W, H>::win(bool _white) const {
+  if(_white) return (black == 0ULL) | ((white & G::ROW_TOP) != 0ULL);
+  return (white == 0ULL) | ((black & G::ROW_BOTTOM) != 0ULL);
+}
+// même ordre que Lfr_t::get_nth_move : avant, gauche, droite
+template<int W, int H>
+inline
+Move64_t BoardWH_t<W, H>::nth_move(const Lfr_t& _lfr, uint32_t _n, bool _white) const {
+  uint32_t nb_f = uint32_t(count64(_lfr.forward));
+  uint32_t nb_l = uint32_t(count64(_lfr.left));
+  Move64_t m;
+  if(_n < nb_f) {
+    m.pf = select_move(_lfr.forward, _n);
+    m.pi = _white ? m.pf<<G::FORWARD : m.pf>>G::FORWARD;
+  } else if(_n-nb_f < nb_l) {
+    m.pf = select_move(_lfr.left, _n-nb_f);
+    m.pi = _white ? m.pf<<G::DIAG_A_WHITE : m.pf>>G::DIAG_A_BLACK;
+  } else {
+    m.pf = select_move(_lfr.right, _n-nb_f-nb_l);
+    m.pi = _white ? m.pf<<G::DIAG_H_WHITE : m.pf>>G::DIAG_H_BLACK;
+  }
+  return m;
+}
+template<int W, int H>
+inline
+void BoardWH_t<W, H>::apply_move(const Move64_t& _m, bool _white) {
+  if(_white) {
+    white = (white^_m.pi)|_m.pf;
+    black &= ~_m.pf;
+  } else {
+    black = (black^_m.pi)|_m.pf;
+    white &= ~_m.pf;
+  }
+}
+// matériel et avancée (rangées parcourues), du point de vue de _white
+template<int W, int H>
+inline
+int BoardWH_t<W, H>::eval(bool _white) const {
+  int s = 100*(int(count64(white))-int(count64(black)));
+  for(int r = 0; r < H; r++) {
+    s += 4*(H-1-r)*int(count64(white & G::row(r)));
+    s -= 4*r*int(count64(black & G::row(r)));
+  }
+  return _white ? s : -s;
+}
+// true si les blancs gagnent ; un camp sans coup perd
+template<int W, int H>
+template<class Rng>
+inline
+bool BoardWH_t<W, H>::seq_playout(bool _white, Rng& _rng) {
+  BK_PROF_COUNT(PROF_PLAYOUTS);
+  while(1) {
+    Lfr_t l = lfr(_white);
+    uint32_t nb = l.nb_moves();
+    if(nb == 0) return !_white;
+    apply_move(nth_move(l, _rng.bounded(nb), _white), _white);
+    if(win(_white)) return _white;
+    _white = !_white;
+  }
+}
+// feuilles à _depth demi-coups ; une partie gagnée est une feuille
+template<int W, int H>
+inline
+uint64_t BoardWH_t<W, H>::perft(int _depth, bool _white) const {
+  Lfr_t l = lfr(_white);
+  uint32_t nb = l.nb_moves();
+  if(_depth == 1) return nb;
+  uint64_t n = 0;
+  for(uint32_t i = 0; i < nb; i++) {
+    BoardWH_t b = *this;
+    b.apply_move(nth_move(l, i, _white), _white);
+    n += b.win(_white) ? 1 : b.perft(_depth-1, !_white);
+  }
+  return n;
+}
+template<int W, int H>
+inline
+void BoardWH_t<W, H>::print_board(FILE* _out) const {
+  for(int r = 0; r < H; r++) {
+    fprintf(_out, "%2d ", H-r);
+    for(int c = 0; c < W; c++) {
+      int sq = r*W+c;
+      fprintf(_out, "%c ", ((black>>sq) & 1ULL) ? '@' : (((white>>sq) & 1ULL) ? 'O' : '.'));
+    }
+    fprintf(_out, "\n");
+  }
+  fprintf(_out, "   ");
+  for(int c = 0; c < W; c++) fprintf(_out, "%c ", 'A'+c);
+  fprintf(_out, "\n");
+}
+
+// recherche alpha-beta en approfondissement itératif, sans table : assez
+// pour résoudre les petits plateaux. Scores du point de vue du camp au
+// trait, WH_WIN-ply pour une victoire
+static const int WH_WIN = 1000000;
+
+struct WhResult_t {
+  Move64_t move;
+  int score;
+  int depth;      // dernière profondeur terminée
+  uint64_t nodes;
+  double ms;
+  bool solved;    // score de victoire ou de défaite prouvé
+};
+
+template<int W, int H>
+struct SearchWH_t {
+  uint64_t nodes;
+  bool stop;
+  double time_ms;
+  std::chrono::steady_clock::time_point start;
+
+  SearchWH_t() : nodes(0), stop(false), time_ms(0.0) {}
+  int alphabeta(const BoardWH_t<W, H>& _b, bool _white, int _depth, int _ply, int _alpha, int _beta);
+  WhResult_t think(const BoardWH_t<W, H>& _b, bool _white, int _max_depth, double _time_ms);
+};
+
+// prises d'abord : la diagonale vers une pièce adverse avant les autres coups
+template<int W, int H>
+inline
+int SearchWH_t<W, H>::alphabeta(const BoardWH_t<W, H>& _b, bool _white, int _depth, int _ply, int _alpha, int _beta) {
+  nodes++;
+  if((nodes & 1023) == 0 && time_ms > 0.0 &&
+     std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count() > time_ms)
+    stop = true;
+  if(stop) return 0;
+  if(_depth == 0) return _b.eval(_white);
+  Lfr_t l = _b.lfr(_white);
+  uint32_t nb = l.nb_moves();
+  if(nb == 0) return -(WH_WIN-_ply);
+  uint64_t opp = _white ? _b.black : _b.white;
+  for(int pass = 0; pass < 2; pass++) {
+    for(uint32_t i = 0; i < nb; i++) {
+      Move64_t m = _b.nth_move(l, i, _white);
+      if(((m.pf & opp) != 0ULL) != (pass == 0)) continue;
+      BoardWH_t<W, H> b = _b;
+      b.apply_move(m, _white);
+      int s = b.win(_white) ? WH_WIN-_ply-1 : -alphabeta(b, !_white, _depth-1, _ply+1, -_beta, -_alpha);
+      if(stop) return 0;
+      if(s >= _beta) return s;
+      if(s > _alpha) _alpha = s;
+    }
+  }
+  return _alpha;
+}
+
+template<int W, int H>
+inline
+WhResult_t SearchWH_t<W, H>::think(const BoardWH_t<W, H>& _b, bool _white, int _max_depth, double _time_ms) {
+  start = std::chrono::steady_clock::now();
+  time_ms = _time_ms;
+  nodes = 0;
+  stop = false;
+  WhResult_t res;
+  res.move.pi = res.move.pf = 0ULL;
+  res.score = 0;
+  res.depth = 0;
+  res.solved = false;
+  Lfr_t l = _b.lfr(_white);
+  uint32_t nb = l.nb_moves();
+  for(int depth = 1; depth <= _max_depth && nb > 0 && !res.solved; depth++) {
+    Move64_t best = _b.nth_move(l, 0, _white);
+    int alpha = -WH_WIN-1;
+    for(uint32_t i = 0; i < nb; i++) {
+      // le meilleur coup de l'itération précédente d'abord
+      Move64_t m = i == 0 && res.depth > 0 ? res.move : _b.nth_move(l, i, _white);
+      if(i > 0 && res.depth > 0 && m == res.move) m = _b.nth_move(l, 0, _white);
+      BoardWH_t<W, H> b = _b;
+      b.apply_move(m, _white);
+      int s = b.win(_white) ? WH_WIN-1 : -alphabeta(b, !_white, depth-1, 1, -WH_WIN-1, -alpha);
+      if(stop) break;
+      if(s > alpha) {
+        alpha = s;
+        best = m;
+      }
+    }
+    if(stop) break;
+    res.move = best;
+    res.score = alpha;
+    res.depth = depth;
+    res.solved = alpha >= WH_WIN-_max_depth || alpha <= -WH_WIN+_max_depth;
+  }
+  res.nodes = nodes;
+  res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+  return res;
+}
+
+#endif /* BKBB64_WH_H */
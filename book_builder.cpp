@@ -0,0 +1,108 @@
+// construction du livre d'ouvertures : toutes les positions des premiers
+// demi-coups sont cherchées en parallèle avec la recherche la plus forte
+// $>./book_builder book.bin [demi-coups] [ms par position] [threads] [cache]
+// avec un fichier cache (voir bkbb64_cache.h), les recherches le préchauffent
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "bkbb64_search.h"
+#include "bkbb64_book.h"
+
+struct BookPosition_t {
+  Board64_t board;
+  bool white;
+  uint64_t key;
+};
+
+static inline
+bool book_position_less(const BookPosition_t& _a, const BookPosition_t& _b) {
+  return _a.key < _b.key;
+}
+
+// positions distinctes (à la symétrie près) jusqu'à _plies demi-coups
+std::vector<BookPosition_t> book_positions(int _plies) {
+  std::vector<BookPosition_t> all;
+  std::vector<BookPosition_t> level(1);
+  level[0].board = Board64_t();
+  level[0].white = true;
+  level[0].key = level[0].board.canonical_hash(true, NULL);
+  for(int ply = 0; ply < _plies; ply++) {
+    all.insert(all.end(), level.begin(), level.end());
+    if(ply+1 == _plies) break;
+    std::vector<BookPosition_t> next;
+    for(size_t i = 0; i < level.size(); i++) {
+      MoveList64_t l;
+      gen_moves(level[i].board, level[i].white, l);
+      for(int j = 0; j < l.size; j++) {
+        BookPosition_t p;
+        p.board = level[i].board;
+        p.board.apply_move(l.moves[j].move);
+        if(p.board.win(level[i].white)) continue;
+        p.white = !level[i].white;
+        p.key = p.board.canonical_hash(p.white, NULL);
+        next.push_back(p);
+      }
+    }
+    std::sort(next.begin(), next.end(), book_position_less);
+    size_t n = 0;
+    for(size_t i = 0; i < next.size(); i++)
+      if(n == 0 || next[i].key != next[n-1].key) next[n++] = next[i];
+    next.resize(n);
+    level.swap(next);
+  }
+  return all;
+}
+
+int main(int _ac, char** _av) {
+  if(_ac < 2) {
+    fprintf(stderr, "usage: %s BOOK [PLIES] [MS] [THREADS] [CACHE]\n", _av[0]);
+    return 1;
+  }
+  int plies = _ac > 2 ? atoi(_av[2]) : 3;
+  double ms = _ac > 3 ? atof(_av[3]) : 1000.0;
+  int nb_threads = _ac > 4 ? atoi(_av[4]) : int(std::thread::hardware_concurrency());
+  if(nb_threads < 1) nb_threads = 1;
+  DiskCache_t cache;
+  if(_ac > 5 && !cache.open(_av[5], size_t(64)<<20)) {
+    fprintf(stderr, "error: cannot open cache %s\n", _av[5]);
+    return 1;
+  }
+
+  std::vector<BookPosition_t> positions = book_positions(plies);
+  std::vector<BookEntry_t> entries(positions.size());
+  fprintf(stderr, "%d positions, %d threads, %.0f ms each\n", (int)positions.size(), nb_threads, ms);
+
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> threads;
+  for(int t = 0; t < nb_threads; t++) {
+    threads.push_back(std::thread([&]() {
+      Search64_t s(20);
+      s.opt = SearchOptions_t::all();
+      if(cache.header) s.disk = &cache;
+      size_t i;
+      while((i = next++) < positions.size()) {
+        // recherche dans l'orientation canonique, le coup est stocké tel quel
+        const BookPosition_t& p = positions[i];
+        Board64_t b = p.board.is_mirror_smaller() ? p.board.mirror() : p.board;
+        SearchResult_t r = s.think(b, p.white, MAX_PLY-2, ms);
+        entries[i].key = p.key;
+        entries[i].from = uint8_t(r.move.from());
+        entries[i].to = uint8_t(r.move.to());
+        entries[i].depth = int16_t(r.depth);
+        entries[i].score = r.score;
+      }
+    }));
+  }
+  for(size_t t = 0; t < threads.size(); t++) threads[t].join();
+
+  std::sort(entries.begin(), entries.end(), book_entry_less);
+  if(!book_write(_av[1], entries.empty() ? NULL : &entries[0], entries.size(), true, plies)) {
+    fprintf(stderr, "error: cannot write %s\n", _av[1]);
+    return 1;
+  }
+  fprintf(stderr, "%d entries written to %s\n", (int)entries.size(), _av[1]);
+  return 0;
+}
@@ -1,19 +1,24 @@
 #include "breakthrough_simple.hpp"
 
+// plateau vide si la chaine est invalide (voir parse_board64)
 void init_plateau(Plateau *p, const char *str)
 {
-    for (int i = 0; i < 8; i++)
+    uint64_t blancs = 0ULL;
+    uint64_t noirs = 0ULL;
+    parse_board64(str, blancs, noirs);
+    plateau_depuis_bitboards(p, blancs, noirs);
+}
+
+void plateau_depuis_bitboards(Plateau *p, uint64_t blancs, uint64_t noirs)
+{
+    for (int i = 0; i < 64; i++)
     {
-        for (int j = 0; j < 8; j++)
-        {
-            char c = str[i * 8 + j];
-            if (c == '1')
-                p->cases[i][j] = BLACK;
-            else if (c == '0')
-                p->cases[i][j] = WHITE;
-            else
-                p->cases[i][j] = VIDE;
-        }
+        Case c = VIDE;
+        if ((noirs >> i) & 1ULL)
+            c = BLACK;
+        else if ((blancs >> i) & 1ULL)
+            c = WHITE;
+        p->cases[i / 8][i % 8] = c;
     }
 }
 
@@ -337,6 +342,1289 @@ Coup choisir_coup_my_algo(Plateau *p, Case joueur)
     return evaluations[meilleur_idx].coup;
 }
 
+Board64_t plateau_vers_board64(const Plateau *p)
+{
+    Board64_t b;
+    b.white = 0ULL;
+    b.black = 0ULL;
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            if (p->cases[i][j] == BLACK)
+                b.black |= 1ULL << (i * 8 + j);
+            else if (p->cases[i][j] == WHITE)
+                b.white |= 1ULL << (i * 8 + j);
+        }
+    }
+    return b;
+}
+
+Coup move16_vers_coup(const Move16_t &m)
+{
+    int from = m.from();
+    int to = m.to();
+    Coup c;
+    c.from.ligne = from / 8;
+    c.from.col = from % 8;
+    c.to.ligne = to / 8;
+    c.to.col = to % 8;
+    return c;
+}
+
+Coup choisir_coup_alphabeta(Plateau *p, Case joueur, const OptionsIA *opt)
+{
+    Board64_t b = plateau_vers_board64(p);
+    bool blanc = (joueur == WHITE);
+
+    MoveList64_t coups;
+    gen_moves(b, blanc, coups);
+    if (coups.size == 0)
+    {
+        Coup c;
+        c.from.ligne = -1;
+        return c;
+    }
+
+    // sonde pns : une victoire forcee courte est jouee sans recherche
+    double temps_ms = opt->temps_ms;
+    double pns_ms = opt->pns_ms;
+    if (pns_ms < 0)
+    {
+        pns_ms = (strcmp(opt->algo, "pvs") == 0) ? opt->temps_ms / 20 : 0;
+    }
+    if (strcmp(opt->algo, "pns") == 0)
+    {
+        pns_ms = opt->temps_ms;
+    }
+    if (pns_ms > 0 && (pns_worth_probing(b) || strcmp(opt->algo, "pns") == 0))
+    {
+        PnsSolver_t solveur(size_t(opt->pns_mem_mo) << 20);
+        PnsResult_t pr = solveur.solve(b, blanc, pns_ms);
+        if (opt->verbeux)
+        {
+            const char *etats[3] = {"inconnu", "gagne", "perdu"};
+            fprintf(stderr, "pns: %s coup %s preuve %u noeuds %llu temps %.1f ms\n",
+                    etats[pr.status], pr.status == PNS_WIN ? pr.move.to_str().c_str() : "-",
+                    pr.proof_size, (unsigned long long)pr.nodes, pr.ms);
+        }
+        if (pr.status == PNS_WIN)
+        {
+            return move16_vers_coup(pr.move);
+        }
+        temps_ms -= pr.ms;
+        if (temps_ms < 1)
+        {
+            temps_ms = 1;
+        }
+    }
+
+    Search64_t recherche;
+    recherche.opt = opt->recherche;
+    DiskCache_t cache;
+    if (opt->cache)
+    {
+        if (cache.open(opt->cache, size_t(opt->cache_mo) << 20))
+            recherche.disk = &cache;
+        else if (opt->verbeux)
+            fprintf(stderr, "cache: impossible d'ouvrir %s\n", opt->cache);
+    }
+    marquer_chrono(CHRONO_TABLES);
+    SearchResult_t res = recherche.think(b, blanc, opt->profondeur, temps_ms,
+                                         opt->verbeux ? stderr : NULL);
+    if (opt->verbeux)
+    {
+        fprintf(stderr, "alphabeta: profondeur %d score %d noeuds %llu temps %.1f ms\n",
+                res.depth, res.score, (unsigned long long)res.nodes, res.ms);
+        recherche.stats.print(stderr);
+        if (recherche.disk)
+            fprintf(stderr, "cache: %llu/%llu trouves, %llu ecrits\n",
+                    (unsigned long long)cache.hits, (unsigned long long)cache.probes,
+                    (unsigned long long)cache.stores);
+    }
+    return move16_vers_coup(res.move);
+}
+
+Coup choisir_coup_mcts(Plateau *p, Case joueur, const OptionsIA *opt)
+{
+    Board64_t b = plateau_vers_board64(p);
+    bool blanc = (joueur == WHITE);
+    Mcts64_t arbre(size_t(opt->mcts_mem_mo) << 20, (uint64_t)time(NULL));
+    if (opt->rave_k > 0)
+        arbre.set_rave(float(opt->rave_k), MCTS_RAVE_C);
+    if (opt->motifs)
+        arbre.set_patterns(MCTS_PATTERN_BIAS, MCTS_WIDEN_K0);
+    marquer_chrono(CHRONO_TABLES);
+    MctsResult_t res = arbre.think(b, blanc, opt->temps_ms);
+    if (res.move.is_null())
+    {
+        Coup c;
+        c.from.ligne = -1;
+        return c;
+    }
+    if (opt->verbeux)
+    {
+        fprintf(stderr, "mcts: %s visites %u victoires %.3f iterations %llu noeuds %llu temps %.1f ms\n",
+                res.move.to_str().c_str(), res.visits, res.win_rate,
+                (unsigned long long)res.iterations, (unsigned long long)res.nodes, res.ms);
+    }
+    return move16_vers_coup(res.move);
+}
+
+// monte carlo a plat, elimination par moitiés sur opt->threads threads
+Coup choisir_coup_flat(Plateau *p, Case joueur, const OptionsIA *opt)
+{
+    Board64_t b = plateau_vers_board64(p);
+    FlatMc64_t flat(opt->threads, (uint64_t)time(NULL));
+    marquer_chrono(CHRONO_TABLES);
+    FlatResult_t res = flat.think(b, joueur == WHITE, opt->temps_ms);
+    if (res.move.is_null())
+    {
+        Coup c;
+        c.from.ligne = -1;
+        return c;
+    }
+    if (opt->verbeux)
+    {
+        fprintf(stderr, "flat: %s victoires %.3f playouts %llu manches %d threads %d temps %.1f ms\n",
+                res.move.to_str().c_str(), res.win_rate, (unsigned long long)res.playouts, res.rounds,
+                opt->threads, res.ms);
+    }
+    return move16_vers_coup(res.move);
+}
+
+bool chercher_coup_livre(const Plateau *p, Case joueur, const OptionsIA *opt, Coup *c)
+{
+    BK_PROF_SCOPE(PHASE_BOOK);
+    Book_t livre;
+    if (!livre.open(opt->livre))
+    {
+        if (opt->verbeux)
+            fprintf(stderr, "livre: impossible d'ouvrir %s\n", opt->livre);
+        return false;
+    }
+    Board64_t b = plateau_vers_board64(p);
+    Move16_t m;
+    BookEntry_t e;
+    if (!livre.find(b, joueur == WHITE, m, &e))
+        return false;
+    if (opt->verbeux)
+        fprintf(stderr, "livre: %s score %d profondeur %d\n", m.to_str().c_str(), e.score, e.depth);
+    *c = move16_vers_coup(m);
+    return true;
+}
+
+// statistiques de la base de positions pour chaque coup joue depuis la
+// racine, sur stderr, les plus joues d'abord
+void rapporter_posdb(const Plateau *p, Case joueur, const OptionsIA *opt)
+{
+    PosDb_t base;
+    if (!base.open(opt->posdb))
+    {
+        fprintf(stderr, "posdb: impossible d'ouvrir %s\n", opt->posdb);
+        return;
+    }
+    std::vector<PosDbMove_t> coups;
+    uint32_t parties = base.find(plateau_vers_board64(p), joueur == WHITE, coups);
+    std::sort(coups.begin(), coups.end(),
+              [](const PosDbMove_t &a, const PosDbMove_t &b) { return a.games > b.games; });
+    fprintf(stderr, "posdb: %u parties sur %llu\n", parties, (unsigned long long)base.header->nb_games);
+    for (size_t i = 0; i < coups.size(); i++)
+    {
+        fprintf(stderr, "posdb: %s parties %u victoires %u (%.1f%%)\n", coups[i].move.to_str().c_str(),
+                coups[i].games, coups[i].wins, 100.0 * coups[i].wins / coups[i].games);
+    }
+}
+
+void options_par_defaut(OptionsIA *opt)
+{
+    opt->algo = "flat";
+    opt->temps_ms = 0; // selon l'algorithme, voir lire_options
+    opt->profondeur = 64;
+    opt->verbeux = false;
+    opt->chrono = false;
+    opt->recherche = SearchOptions_t();
+    opt->pns_ms = -1;
+    opt->pns_mem_mo = 64;
+    opt->mcts_mem_mo = 256;
+    opt->rave_k = 0;
+    opt->motifs = false;
+    opt->livre = NULL;
+    opt->posdb = NULL;
+    opt->cache = NULL;
+    opt->cache_mo = 64;
+    opt->threads = int(std::thread::hardware_concurrency());
+    if (opt->threads < 1)
+        opt->threads = 1;
+    opt->json = false;
+    opt->prof = NULL;
+    opt->tranche_ms = 10;
+    opt->pas = 0;
+    opt->tt_mo = 256;
+    opt->tt_jeu_mo = 0;
+    opt->ponder_ms = 0;
+}
+
+// compteurs et temps par phase sur stderr (binaire compile avec make PROF=1)
+void afficher_prof(const OptionsIA *opt, const char *etiquette)
+{
+    if (!opt->prof)
+        return;
+    if (!PROF_ENABLED)
+    {
+        fprintf(stderr, "prof: instrumentation absente, recompiler avec make PROF=1\n");
+        return;
+    }
+    prof_dump(stderr, strcmp(opt->prof, "json") == 0, etiquette);
+}
+
+// instants CLOCK_MONOTONIC (ns) des etapes du mode coup unique : startup_bench
+// les compare a l'instant ou il a lance le processus ; une etape sautee
+// (coup du livre, sans table) prend l'instant de la precedente
+static long long instants_chrono[CHRONO_NB];
+
+void marquer_chrono(int etape)
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    instants_chrono[etape] = (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// sur stderr, apres la reponse pour ne pas la retarder
+void afficher_chrono()
+{
+    for (int i = 1; i < CHRONO_NB; i++)
+        if (instants_chrono[i] == 0)
+            instants_chrono[i] = instants_chrono[i - 1];
+    fprintf(stderr, "chrono main %lld analyse %lld tables %lld recherche %lld sortie %lld\n",
+            instants_chrono[CHRONO_MAIN], instants_chrono[CHRONO_ANALYSE], instants_chrono[CHRONO_TABLES],
+            instants_chrono[CHRONO_RECHERCHE], instants_chrono[CHRONO_SORTIE]);
+}
+
+void appliquer_techniques(SearchOptions_t *r, int activer, int desactiver)
+{
+    int actives = (r->pvs ? TECH_PVS : 0) | (r->aspiration ? TECH_ASPIRATION : 0) |
+                  (r->lmr ? TECH_LMR : 0) | (r->lmr_research ? TECH_VERIF : 0) |
+                  (r->quiescence ? TECH_QUIESCENCE : 0) | (r->mirror_tt ? TECH_SYMETRIE : 0) |
+                  (r->pawn_eval ? TECH_PIONS : 0) | (r->see ? TECH_SEE : 0);
+    actives = (actives | activer) & ~desactiver;
+    r->pvs = (actives & TECH_PVS) != 0;
+    r->aspiration = (actives & TECH_ASPIRATION) != 0;
+    r->lmr = (actives & TECH_LMR) != 0;
+    r->lmr_research = (actives & TECH_VERIF) != 0;
+    r->quiescence = (actives & TECH_QUIESCENCE) != 0;
+    r->mirror_tt = (actives & TECH_SYMETRIE) != 0;
+    r->pawn_eval = (actives & TECH_PIONS) != 0;
+    r->see = (actives & TECH_SEE) != 0;
+}
+
+// -algo pvs active toutes les techniques, -pvs/-nopvs etc. les reglent une par une
+bool lire_options(int argc, char **argv, int debut, OptionsIA *opt)
+{
+    const char *noms[8] = {"pvs", "asp", "lmr", "verif", "qs", "sym", "pions", "see"};
+    int activer = 0;
+    int desactiver = 0;
+    for (int i = debut; i < argc; i++)
+    {
+        bool technique = false;
+        for (int t = 0; t < 8; t++)
+        {
+            if (argv[i][0] == '-' && strcmp(argv[i] + 1, noms[t]) == 0)
+            {
+                activer |= 1 << t;
+                technique = true;
+            }
+            else if (strncmp(argv[i], "-no", 3) == 0 && strcmp(argv[i] + 3, noms[t]) == 0)
+            {
+                desactiver |= 1 << t;
+                technique = true;
+            }
+        }
+        if (technique)
+        {
+            continue;
+        }
+        if (strcmp(argv[i], "-v") == 0)
+        {
+            opt->verbeux = true;
+        }
+        else if (strcmp(argv[i], "-chrono") == 0)
+        {
+            opt->chrono = true;
+        }
+        else if (strcmp(argv[i], "-algo") == 0 && i + 1 < argc)
+        {
+            opt->algo = argv[++i];
+        }
+        else if (strcmp(argv[i], "-temps") == 0 && i + 1 < argc)
+        {
+            opt->temps_ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-prof") == 0 && i + 1 < argc)
+        {
+            opt->profondeur = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-pns") == 0 && i + 1 < argc)
+        {
+            opt->pns_ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-pnsmem") == 0 && i + 1 < argc)
+        {
+            opt->pns_mem_mo = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-mctsmem") == 0 && i + 1 < argc)
+        {
+            opt->mcts_mem_mo = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-rave") == 0 && i + 1 < argc)
+        {
+            opt->rave_k = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-motifs") == 0)
+        {
+            opt->motifs = true;
+        }
+        else if (strcmp(argv[i], "-livre") == 0 && i + 1 < argc)
+        {
+            opt->livre = argv[++i];
+        }
+        else if (strcmp(argv[i], "-posdb") == 0 && i + 1 < argc)
+        {
+            opt->posdb = argv[++i];
+        }
+        else if (strcmp(argv[i], "-cache") == 0 && i + 1 < argc)
+        {
+            opt->cache = argv[++i];
+        }
+        else if (strcmp(argv[i], "-cachemo") == 0 && i + 1 < argc)
+        {
+            opt->cache_mo = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+        {
+            opt->threads = atoi(argv[++i]);
+            if (opt->threads < 1)
+                opt->threads = 1;
+        }
+        else if (strcmp(argv[i], "-format") == 0 && i + 1 < argc)
+        {
+            opt->json = (strcmp(argv[++i], "json") == 0);
+        }
+        else if (strcmp(argv[i], "-instr") == 0 && i + 1 < argc)
+        {
+            opt->prof = argv[++i];
+        }
+        else if (strcmp(argv[i], "-tranche") == 0 && i + 1 < argc)
+        {
+            opt->tranche_ms = atof(argv[++i]);
+            if (opt->tranche_ms < 1)
+                opt->tranche_ms = 1;
+        }
+        else if (strcmp(argv[i], "-pas") == 0 && i + 1 < argc)
+        {
+            opt->pas = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-ttmo") == 0 && i + 1 < argc)
+        {
+            opt->tt_mo = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-ttjeu") == 0 && i + 1 < argc)
+        {
+            opt->tt_jeu_mo = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-ponder") == 0 && i + 1 < argc)
+        {
+            opt->ponder_ms = atof(argv[++i]);
+        }
+        // reglages memoire communs au processus : lus avant d'allouer les tables
+        else if (strcmp(argv[i], "-pages") == 0 && i + 1 < argc && mem_parse(argv[i + 1], HUGE_NAMES) >= 0)
+        {
+            mem_options().huge = mem_parse(argv[++i], HUGE_NAMES);
+        }
+        else if (strcmp(argv[i], "-numa") == 0 && i + 1 < argc && mem_parse(argv[i + 1], NUMA_NAMES) >= 0)
+        {
+            mem_options().numa = mem_parse(argv[++i], NUMA_NAMES);
+        }
+        else if (strcmp(argv[i], "-epingler") == 0)
+        {
+            mem_options().pin = true;
+        }
+        else
+        {
+            fprintf(stderr, "Erreur: option inconnue '%s'\n", argv[i]);
+            return false;
+        }
+    }
+    if (strcmp(opt->algo, "pvs") == 0 || strcmp(opt->algo, "pns") == 0)
+    {
+        opt->recherche = SearchOptions_t::all();
+        opt->recherche.pawn_eval = true;
+    }
+    appliquer_techniques(&opt->recherche, activer, desactiver);
+    if (opt->temps_ms <= 0)
+    {
+        opt->temps_ms = (strcmp(opt->algo, "flat") == 0) ? 100.0 : 500.0;
+    }
+    return true;
+}
+
+// ligne "<plateau 64 cases> <joueur>", meme notation qu'en ligne de commande
+// (l'un ou l'autre alphabet) ; le plateau est lu sur place dans la ligne
+bool lire_ligne_batch(const char *ligne, PositionBatch *pos)
+{
+    pos->valide = false;
+    pos->plateau[0] = '\0';
+    pos->joueur = '?';
+    const char *s = ligne + strspn(ligne, " \t");
+    size_t n = strcspn(s, " \t\r\n");
+    if (n != 64 || parse_board64(s, n, pos->blancs, pos->noirs) != BOARD_PARSE_OK)
+        return false;
+    memcpy(pos->plateau, s, 64);
+    pos->plateau[64] = '\0';
+    s += 64;
+    s += strspn(s, " \t");
+    char joueur[2] = {*s, '\0'};
+    if (parse_side(joueur) < 0 || (s[1] != '\0' && !strchr(" \t\r\n", s[1])))
+        return false;
+    pos->joueur = *s;
+    pos->valide = true;
+    return true;
+}
+
+void analyser_position_batch(Search64_t *recherche, PositionBatch *pos, const OptionsIA *opt)
+{
+    pos->coup = MOVE16_NONE;
+    pos->score = 0;
+    pos->profondeur = 0;
+    pos->noeuds = 0;
+    pos->ms = 0;
+    if (!pos->valide)
+        return;
+    Board64_t b;
+    b.white = pos->blancs;
+    b.black = pos->noirs;
+    bool blanc = (pos->joueur == '0' || pos->joueur == 'O');
+    MoveList64_t coups;
+    gen_moves(b, blanc, coups);
+    if (coups.size == 0)
+        return;
+    SearchResult_t res = recherche->think(b, blanc, opt->profondeur, opt->temps_ms);
+    pos->coup = res.move;
+    pos->score = res.score;
+    pos->profondeur = res.depth;
+    pos->noeuds = res.nodes;
+    pos->ms = res.ms;
+}
+
+void ecrire_resultat_batch(FILE *out, unsigned long long id, const PositionBatch *pos, bool json)
+{
+    Move16_t m = pos->coup;
+    const char *erreur = !pos->valide ? "ligne invalide" : (m.is_null() ? "aucun coup" : NULL);
+    std::string coup = erreur ? std::string("") : m.to_str();
+    if (json)
+    {
+        fprintf(out, "{\"id\":%llu,\"plateau\":\"%s\",\"joueur\":\"%c\",", id, pos->plateau, pos->joueur);
+        if (erreur)
+            fprintf(out, "\"erreur\":\"%s\"}\n", erreur);
+        else
+            fprintf(out, "\"coup\":\"%s\",\"score\":%d,\"profondeur\":%d,\"noeuds\":%llu,\"ms\":%.1f}\n",
+                    coup.c_str(), pos->score, pos->profondeur, pos->noeuds, pos->ms);
+    }
+    else
+    {
+        fprintf(out, "%llu,%s,%c,%s,%d,%d,%llu,%.1f%s%s\n", id, pos->plateau, pos->joueur,
+                coup.c_str(), pos->score, pos->profondeur, pos->noeuds, pos->ms,
+                erreur ? "," : "", erreur ? erreur : "");
+    }
+}
+
+// premiere option lue que le mode batch n'appliquerait pas (NULL : aucune) ;
+// batch ne fait qu'une recherche ab/pvs par position, sans livre ni cache
+const char *option_hors_batch(const OptionsIA *opt)
+{
+    OptionsIA def;
+    options_par_defaut(&def);
+    if (strcmp(opt->algo, "ab") != 0 && strcmp(opt->algo, "pvs") != 0)
+        return "-algo (ab ou pvs seulement)";
+    if (opt->pns_ms != def.pns_ms)
+        return "-pns";
+    if (opt->pns_mem_mo != def.pns_mem_mo)
+        return "-pnsmem";
+    if (opt->mcts_mem_mo != def.mcts_mem_mo)
+        return "-mctsmem";
+    if (opt->rave_k != def.rave_k)
+        return "-rave";
+    if (opt->motifs != def.motifs)
+        return "-motifs";
+    if (opt->livre)
+        return "-livre";
+    if (opt->posdb)
+        return "-posdb";
+    if (opt->cache || opt->cache_mo != def.cache_mo)
+        return "-cache";
+    if (opt->tranche_ms != def.tranche_ms)
+        return "-tranche";
+    if (opt->pas != def.pas)
+        return "-pas";
+    if (opt->tt_mo != def.tt_mo || opt->tt_jeu_mo != def.tt_jeu_mo)
+        return "-ttmo/-ttjeu";
+    if (opt->ponder_ms != def.ponder_ms)
+        return "-ponder";
+    if (opt->chrono)
+        return "-chrono";
+    return NULL;
+}
+
+// analyse un flux de positions par paquets : les threads se partagent un
+// paquet, qui est ecrit dans l'ordre avant de lire le suivant (memoire bornee)
+int mode_batch(int argc, char **argv)
+{
+    const char *entree = "-";
+    int debut = 2;
+    if (argc >= 3 && (argv[2][0] != '-' || strcmp(argv[2], "-") == 0))
+    {
+        entree = argv[2];
+        debut = 3;
+    }
+    OptionsIA opt;
+    options_par_defaut(&opt);
+    opt.algo = "pvs";
+    opt.temps_ms = 100;
+    if (!lire_options(argc, argv, debut, &opt))
+        return 1;
+    const char *ignoree = option_hors_batch(&opt);
+    if (ignoree)
+    {
+        fprintf(stderr, "Erreur: option %s sans effet en mode batch\n", ignoree);
+        return 1;
+    }
+
+    FILE *in = strcmp(entree, "-") == 0 ? stdin : fopen(entree, "r");
+    if (!in)
+    {
+        fprintf(stderr, "Erreur: impossible d'ouvrir %s\n", entree);
+        return 1;
+    }
+
+    std::vector<Search64_t *> recherches;
+    for (int t = 0; t < opt.threads; t++)
+    {
+        recherches.push_back(new Search64_t(18));
+        recherches.back()->opt = opt.recherche;
+    }
+
+    if (!opt.json)
+        printf("id,plateau,joueur,coup,score,profondeur,noeuds,ms,erreur\n");
+    const size_t taille_paquet = 16 * opt.threads;
+    std::vector<PositionBatch> paquet(taille_paquet);
+    unsigned long long id = 0;
+    char *ligne = NULL;
+    size_t capacite = 0;
+    bool fin = false;
+    while (!fin)
+    {
+        size_t n = 0;
+        while (n < taille_paquet)
+        {
+            if (getline(&ligne, &capacite, in) < 0)
+            {
+                fin = true;
+                break;
+            }
+            if (ligne[strspn(ligne, " \t\r\n")] == '\0' || ligne[0] == '#')
+                continue;
+            BK_PROF_SCOPE(PHASE_PARSE);
+            lire_ligne_batch(ligne, &paquet[n]);
+            n++;
+        }
+        std::atomic<size_t> suivant(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < opt.threads; t++)
+        {
+            threads.push_back(std::thread([&, t]() {
+                pin_current_thread(t);
+                size_t i;
+                while ((i = suivant++) < n)
+                    analyser_position_batch(recherches[t], &paquet[i], &opt);
+            }));
+        }
+        for (size_t t = 0; t < threads.size(); t++)
+            threads[t].join();
+        BK_PROF_SCOPE(PHASE_OUTPUT);
+        for (size_t i = 0; i < n; i++)
+            ecrire_resultat_batch(stdout, id++, &paquet[i], opt.json);
+        fflush(stdout);
+    }
+    free(ligne);
+    afficher_prof(&opt, "batch");
+    for (size_t t = 0; t < recherches.size(); t++)
+        delete recherches[t];
+    if (in != stdin)
+        fclose(in);
+    return 0;
+}
+
+// plus grande table de transposition (puissance de 2 entrees) tenant dans mo Mo
+int log2_table_tt(int mo)
+{
+    size_t n = (size_t(mo < 1 ? 1 : mo) << 20) / sizeof(TTEntry64_t);
+    int l = 0;
+    while ((size_t(2) << l) <= n)
+        l++;
+    return l;
+}
+
+JeuServeur *creer_jeu_serveur(EtatServeur *s, ClientServeur *c, const char *nom)
+{
+    JeuServeur *jeu = new JeuServeur();
+    jeu->nom = nom;
+    jeu->client = c->id;
+    jeu->blanc = true;
+    jeu->horloge_ms = -1;
+    jeu->budget_ms = 0;
+    jeu->occupe = false;
+    jeu->supprimer = false;
+    jeu->arbre = NULL;
+    jeu->recherche = NULL;
+    jeu->tache = NULL;
+    jeu->tranches = 0;
+    jeu->nouvelle = false;
+    jeu->ponder = false;
+    jeu->interrompre = false;
+    jeu->reflexion = false;
+    jeu->ponder_ms = 0;
+    jeu->ponder_iterations = 0;
+    jeu->blanc_ponder = true;
+    if (strcmp(s->opt->algo, "mcts") == 0)
+    {
+        jeu->arbre = new Mcts64_t(size_t(s->opt->mcts_mem_mo) << 20, (uint64_t)time(NULL) + s->nb_jeux);
+        if (s->opt->rave_k > 0)
+            jeu->arbre->set_rave(float(s->opt->rave_k), MCTS_RAVE_C);
+        if (s->opt->motifs)
+            jeu->arbre->set_patterns(MCTS_PATTERN_BIAS, MCTS_WIDEN_K0);
+        jeu->arbre->reset(Board64_t(), true);
+    }
+    else if (s->opt->tt_jeu_mo > 0)
+    {
+        jeu->recherche = new Search64_t(log2_table_tt(s->opt->tt_jeu_mo));
+    }
+    else
+    {
+        jeu->recherche = new Search64_t(0);
+        jeu->recherche->shared_tt = s->tt_commune;
+    }
+    if (jeu->recherche)
+    {
+        jeu->recherche->opt = s->opt->recherche;
+        jeu->recherche->abort_flag = &jeu->interrompre;
+        jeu->tache = new AbTask64_t(*jeu->recherche);
+    }
+    s->nb_jeux++;
+    c->jeux[jeu->nom] = jeu;
+    return jeu;
+}
+
+void detruire_jeu_serveur(EtatServeur *s, JeuServeur *jeu)
+{
+    delete jeu->arbre;
+    delete jeu->tache;
+    delete jeu->recherche;
+    delete jeu;
+    s->nb_jeux--;
+}
+
+// appele depuis les threads de la reserve : le thread principal est reveille
+// par le tube et ecrit la ligne (s'il y en a une) sur la connexion ; fin rend
+// la partie au thread principal
+void poster_reponse_serveur(EtatServeur *s, JeuServeur *jeu, const std::string &ligne, bool fin)
+{
+    {
+        std::lock_guard<std::mutex> g(s->verrou);
+        ReponseServeur r;
+        r.jeu = jeu;
+        r.ligne = ligne;
+        r.fin = fin;
+        s->reponses.push_back(r);
+    }
+    char octet = 1;
+    while (write(s->reveil[1], &octet, 1) < 0 && errno == EINTR)
+    {
+    }
+}
+
+// premiere tranche d'une recherche : garde le sous-arbre mcts de la position
+// demandee, ou reprend la tache alpha-beta si la reflexion visait cette
+// position ; le gain est le temps de reflexion utile a ce coup
+void commencer_recherche_serveur(EtatServeur *s, JeuServeur *jeu, char *info, size_t taille)
+{
+    bool touche = false;
+    double gain = 0;
+    info[0] = '\0';
+    if (jeu->arbre)
+    {
+        uint32_t premier = jeu->arbre->first_child[0];
+        uint32_t trouve = MCTS_NONE;
+        touche = jeu->arbre->reuse(jeu->plateau, jeu->blanc, &trouve);
+        if (!touche)
+            jeu->arbre->reset(jeu->plateau, jeu->blanc);
+        else if (jeu->reflexion && jeu->ponder_iterations > 0)
+        {
+            uint32_t avant = 0;
+            if (trouve >= premier && trouve - premier < jeu->visites_avant.size())
+                avant = jeu->visites_avant[trouve - premier];
+            gain = jeu->ponder_ms * double(jeu->arbre->visits[0] - avant) / double(jeu->ponder_iterations);
+        }
+        snprintf(info, taille, " reprise %u", jeu->arbre->visits[0]);
+    }
+    else
+    {
+        touche = jeu->reflexion && jeu->plateau == jeu->plateau_ponder && jeu->blanc == jeu->blanc_ponder;
+        // meme recherche : la tache reprend ou la reflexion s'est arretee,
+        // au milieu d'une profondeur s'il le faut
+        if (touche)
+            gain = jeu->ponder_ms;
+        else
+            jeu->tache->start(jeu->plateau, jeu->blanc, s->opt->profondeur, jeu->budget_ms);
+        jeu->recherche->time_limit_ms = jeu->budget_ms;
+        jeu->recherche->start = jeu->demande;
+        jeu->recherche->abort_flag = &jeu->interrompre;
+    }
+    if (jeu->reflexion)
+    {
+        (touche ? s->ponder_touches : s->ponder_rates)++;
+        s->ponder_gain_us += (unsigned long long)(gain * 1000);
+        size_t n = strlen(info);
+        snprintf(info + n, taille - n, " ponder %s gain %.0f", touche ? "hit" : "miss", gain);
+    }
+    jeu->reflexion = false;
+}
+
+// apres le coup _m : la reflexion mcts poursuit le sous-arbre de _m (toutes
+// les reponses adverses), la reflexion alpha-beta cherche la position apres
+// la reponse prevue par la table ; false s'il n'y a rien a preparer
+bool preparer_reflexion_serveur(EtatServeur *s, JeuServeur *jeu, const Move16_t &m)
+{
+    Board64_t apres = jeu->plateau;
+    apres.apply_move(m);
+    if (apres.win(jeu->blanc))
+        return false;
+    if (jeu->arbre)
+    {
+        if (!jeu->arbre->reuse(apres, !jeu->blanc))
+            return false;
+        const Mcts64_t &t = *jeu->arbre;
+        jeu->visites_avant.assign(t.visits.begin() + (t.nb_children[0] ? t.first_child[0] : 0),
+                                  t.visits.begin() + (t.nb_children[0] ? t.first_child[0] + t.nb_children[0] : 0));
+    }
+    else
+    {
+        Search64_t *r = jeu->recherche;
+        bool miroir;
+        TTEntry64_t e;
+        if (!r->table().probe(r->tt_key(apres, !jeu->blanc, miroir), e))
+            return false;
+        Move16_t reponse = miroir ? e.move.mirror() : e.move;
+        if (reponse.is_null() || reponse.white() == jeu->blanc || !apres.is_legal(reponse))
+            return false;
+        jeu->plateau_ponder = apres;
+        jeu->plateau_ponder.apply_move(reponse);
+        jeu->blanc_ponder = jeu->blanc;
+        if (jeu->plateau_ponder.win(!jeu->blanc))
+            return false;
+        // ni echeance ni interruption dans la recherche : chaque tranche
+        // s'arrete d'elle-meme et la tache reste suspendue pour le "go" suivant
+        jeu->tache->start(jeu->plateau_ponder, jeu->blanc_ponder, s->opt->profondeur, 0);
+        r->abort_flag = NULL;
+    }
+    jeu->debut_ponder = std::chrono::steady_clock::now();
+    jeu->ponder_ms = 0;
+    jeu->ponder = true;
+    return true;
+}
+
+// une tranche de recherche ; true tant que le budget de la partie n'est pas
+// epuise (la tache repasse alors derriere les autres parties)
+bool tranche_serveur(EtatServeur *s, JeuServeur *jeu)
+{
+    if (jeu->nouvelle)
+    {
+        char reprise[96];
+        commencer_recherche_serveur(s, jeu, reprise, sizeof(reprise));
+        jeu->info_reprise = reprise;
+        jeu->nouvelle = false;
+    }
+    double ecoule = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - jeu->demande).count();
+    double restant = jeu->budget_ms - ecoule;
+    bool fini = restant <= 0 || jeu->interrompre;
+    if (!fini)
+    {
+        jeu->tranches++;
+        double tranche = restant < s->opt->tranche_ms ? restant : s->opt->tranche_ms;
+        // au plus -pas noeuds ou simulations par tranche
+        if (jeu->arbre)
+            jeu->arbre->run(tranche, s->opt->pas ? jeu->arbre->iterations + s->opt->pas : 0);
+        else if (!jeu->tache->step(s->opt->pas, tranche))
+            fini = true;
+        ecoule = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - jeu->demande).count();
+        fini = fini || ecoule >= jeu->budget_ms;
+    }
+    if (!fini)
+        return true;
+
+    if (jeu->horloge_ms >= 0)
+    {
+        jeu->horloge_ms -= ecoule;
+        if (jeu->horloge_ms < 0)
+            jeu->horloge_ms = 0;
+    }
+    char info[160];
+    Move16_t m;
+    if (jeu->arbre)
+    {
+        MctsResult_t res = jeu->arbre->result();
+        m = res.move;
+        snprintf(info, sizeof(info), "iterations %llu victoires %.3f",
+                 (unsigned long long)res.iterations, res.win_rate);
+    }
+    else
+    {
+        SearchResult_t &res = jeu->tache->res;
+        jeu->recherche->finish(jeu->plateau, jeu->blanc, res);
+        m = res.move;
+        snprintf(info, sizeof(info), "profondeur %d score %d noeuds %llu", res.depth, res.score,
+                 (unsigned long long)res.nodes);
+    }
+    char ligne[400];
+    snprintf(ligne, sizeof(ligne), "coup %s %s ms %.1f tranches %llu horloge %.0f %s%s\n", jeu->nom.c_str(),
+             m.to_str().c_str(), ecoule, jeu->tranches, jeu->horloge_ms, info, jeu->info_reprise.c_str());
+    jeu->info_reprise.clear();
+    // la partie reste occupee pendant la reflexion : le "go" suivant
+    // l'interrompt (ponder est pose avant d'envoyer le coup)
+    bool reflechir = s->opt->ponder_ms > 0 && !m.is_null() && !jeu->interrompre &&
+                     preparer_reflexion_serveur(s, jeu, m);
+    poster_reponse_serveur(s, jeu, ligne, !reflechir);
+    if (reflechir)
+        s->reserve->push([s, jeu]() { return tranche_reflexion_serveur(s, jeu); }, -1, true);
+    return false;
+}
+
+// reflexion sur le temps de l'adversaire, en tache de fond : jusqu'a la
+// commande suivante pour cette partie ou -ponder ms ; ponder_ms ne compte
+// que le temps des tranches (pas l'attente derriere les autres parties)
+bool tranche_reflexion_serveur(EtatServeur *s, JeuServeur *jeu)
+{
+    std::chrono::steady_clock::time_point debut = std::chrono::steady_clock::now();
+    double ecoule = std::chrono::duration<double, std::milli>(debut - jeu->debut_ponder).count();
+    bool fini = jeu->interrompre || ecoule >= s->opt->ponder_ms;
+    if (!fini)
+    {
+        double restant = s->opt->ponder_ms - ecoule;
+        double tranche = restant < s->opt->tranche_ms ? restant : s->opt->tranche_ms;
+        if (jeu->arbre)
+            jeu->arbre->run(tranche, s->opt->pas ? jeu->arbre->iterations + s->opt->pas : 0);
+        else
+            fini = !jeu->tache->step(s->opt->pas, tranche);
+        jeu->ponder_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - debut).count();
+    }
+    if (!fini)
+        return true;
+    jeu->ponder_iterations = jeu->arbre ? jeu->arbre->iterations : 0;
+    jeu->reflexion = true;
+    poster_reponse_serveur(s, jeu, "", true);
+    return false;
+}
+
+// une ligne du protocole :
+//   new <jeu> [horloge_ms]            -> ok <jeu>
+//   go <jeu> <plateau> <camp> [ms]    -> coup <jeu> <A2-B3> ms .. tranches .. horloge .. (des que calcule)
+//   del <jeu>                         -> ok <jeu>
+//   stats                             -> stats clients .. jeux .. tranches .. vols .. threads ..
+//   stop                              -> arret du serveur
+// erreurs : "erreur <jeu|-> <message>"
+void commande_serveur(EtatServeur *s, ClientServeur *c, char *ligne)
+{
+    char *mots[6];
+    int n = 0;
+    for (char *m = strtok(ligne, " \t\r"); m && n < 6; m = strtok(NULL, " \t\r"))
+        mots[n++] = m;
+    if (n == 0)
+        return;
+    char reponse[256];
+    const char *nom = n >= 2 ? mots[1] : "-";
+    std::map<std::string, JeuServeur *>::iterator it = c->jeux.find(nom);
+    JeuServeur *jeu = it == c->jeux.end() ? NULL : it->second;
+    if (strcmp(mots[0], "new") == 0 && n >= 2)
+    {
+        if (jeu && jeu->occupe)
+        {
+            snprintf(reponse, sizeof(reponse), "erreur %s recherche en cours\n", nom);
+        }
+        else
+        {
+            if (!jeu)
+                jeu = creer_jeu_serveur(s, c, nom);
+            jeu->horloge_ms = n >= 3 ? atof(mots[2]) : -1;
+            snprintf(reponse, sizeof(reponse), "ok %s\n", nom);
+        }
+    }
+    else if (strcmp(mots[0], "go") == 0 && n >= 4)
+    {
+        uint64_t blancs, noirs;
+        int erreur = parse_board64(mots[2], blancs, noirs);
+        int camp = parse_side(mots[3]);
+        if (erreur != BOARD_PARSE_OK)
+        {
+            snprintf(reponse, sizeof(reponse), "erreur %s plateau invalide (%s)\n", nom, BOARD_PARSE_ERRORS[erreur]);
+        }
+        else if (camp < 0)
+        {
+            snprintf(reponse, sizeof(reponse), "erreur %s camp invalide\n", nom);
+        }
+        else if (jeu && jeu->occupe && jeu->ponder && jeu->go_en_attente.empty())
+        {
+            // la reflexion s'arrete a la fin de sa tranche, puis ce "go" est rejoue
+            jeu->go_en_attente = mots[0];
+            for (int i = 1; i < n; i++)
+                jeu->go_en_attente += std::string(" ") + mots[i];
+            jeu->interrompre = true;
+            return;
+        }
+        else if (jeu && jeu->occupe)
+        {
+            snprintf(reponse, sizeof(reponse), "erreur %s recherche en cours\n", nom);
+        }
+        else
+        {
+            if (!jeu)
+                jeu = creer_jeu_serveur(s, c, nom);
+            jeu->plateau.white = blancs;
+            jeu->plateau.black = noirs;
+            jeu->blanc = (camp == 1);
+            MoveList64_t coups;
+            gen_moves(jeu->plateau, jeu->blanc, coups);
+            if (coups.size == 0)
+            {
+                snprintf(reponse, sizeof(reponse), "erreur %s aucun coup\n", nom);
+            }
+            else
+            {
+                // budget : demande explicite, sinon 1/20 de l'horloge, sinon -temps
+                double budget = n >= 5 ? atof(mots[4]) : (jeu->horloge_ms >= 0 ? jeu->horloge_ms / 20 : s->opt->temps_ms);
+                if (jeu->horloge_ms >= 0 && budget > jeu->horloge_ms)
+                    budget = jeu->horloge_ms;
+                jeu->budget_ms = budget < 1 ? 1 : budget;
+                jeu->demande = std::chrono::steady_clock::now();
+                jeu->tranches = 0;
+                jeu->client = c->id;
+                jeu->nouvelle = true;
+                jeu->occupe = true;
+                s->reserve->push([s, jeu]() { return tranche_serveur(s, jeu); });
+                return;
+            }
+        }
+    }
+    else if (strcmp(mots[0], "del") == 0 && n >= 2)
+    {
+        if (!jeu)
+        {
+            snprintf(reponse, sizeof(reponse), "erreur %s partie inconnue\n", nom);
+        }
+        else
+        {
+            c->jeux.erase(it);
+            if (jeu->occupe)
+            {
+                jeu->supprimer = true;
+                jeu->interrompre = true;
+            }
+            else
+                detruire_jeu_serveur(s, jeu);
+            snprintf(reponse, sizeof(reponse), "ok %s\n", nom);
+        }
+    }
+    else if (strcmp(mots[0], "stats") == 0)
+    {
+        snprintf(reponse, sizeof(reponse),
+                 "stats clients %zu jeux %llu tranches %llu vols %llu threads %d ponder hit %llu miss %llu gain %.0f\n",
+                 s->clients.size(), s->nb_jeux, (unsigned long long)s->reserve->slices,
+                 (unsigned long long)s->reserve->steals, s->reserve->size(), (unsigned long long)s->ponder_touches,
+                 (unsigned long long)s->ponder_rates, s->ponder_gain_us / 1000.0);
+    }
+    else if (strcmp(mots[0], "stop") == 0)
+    {
+        s->arret = true;
+        snprintf(reponse, sizeof(reponse), "ok -\n");
+    }
+    else
+    {
+        snprintf(reponse, sizeof(reponse), "erreur %s commande inconnue '%s'\n", nom, mots[0]);
+    }
+    c->sortie += reponse;
+}
+
+// les parties en cours de recherche sont liberees a l'arrivee de leur reponse
+void fermer_client_serveur(EtatServeur *s, ClientServeur *c)
+{
+    close(c->fd);
+    for (std::map<std::string, JeuServeur *>::iterator it = c->jeux.begin(); it != c->jeux.end(); ++it)
+    {
+        if (it->second->occupe)
+        {
+            it->second->supprimer = true;
+            it->second->interrompre = true;
+        }
+        else
+            detruire_jeu_serveur(s, it->second);
+    }
+    s->clients.erase(c->id);
+    delete c;
+}
+
+static volatile sig_atomic_t signal_arret = 0;
+
+static void arreter_serveur(int)
+{
+    signal_arret = 1;
+}
+
+// recoit les reponses postees par la reserve de threads
+void lire_reponses_serveur(EtatServeur *s)
+{
+    char tampon[256];
+    while (read(s->reveil[0], tampon, sizeof(tampon)) > 0)
+    {
+    }
+    std::vector<ReponseServeur> reponses;
+    {
+        std::lock_guard<std::mutex> g(s->verrou);
+        reponses.swap(s->reponses);
+    }
+    for (size_t i = 0; i < reponses.size(); i++)
+    {
+        JeuServeur *jeu = reponses[i].jeu;
+        std::map<unsigned long long, ClientServeur *>::iterator it = s->clients.find(jeu->client);
+        ClientServeur *c = it == s->clients.end() ? NULL : it->second;
+        if (c && !jeu->supprimer)
+            c->sortie += reponses[i].ligne;
+        if (!reponses[i].fin)
+            continue;
+        jeu->occupe = false;
+        jeu->ponder = false;
+        jeu->interrompre = false;
+        if (jeu->supprimer)
+        {
+            detruire_jeu_serveur(s, jeu);
+            continue;
+        }
+        if (c && !jeu->go_en_attente.empty())
+        {
+            std::string go;
+            go.swap(jeu->go_en_attente);
+            commande_serveur(s, c, &go[0]);
+        }
+    }
+}
+
+// ecrit ce qui peut l'etre sans bloquer ; false si la connexion est perdue
+bool vider_sortie_client(ClientServeur *c)
+{
+    while (!c->sortie.empty())
+    {
+        ssize_t n = send(c->fd, c->sortie.data(), c->sortie.size(), MSG_NOSIGNAL);
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        c->sortie.erase(0, size_t(n));
+    }
+    return true;
+}
+
+// lit les commandes disponibles ; false a la fermeture de la connexion
+bool lire_client(EtatServeur *s, ClientServeur *c)
+{
+    char tampon[4096];
+    while (1)
+    {
+        ssize_t n = read(c->fd, tampon, sizeof(tampon));
+        if (n == 0)
+            return false;
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return false;
+            break;
+        }
+        c->entree.append(tampon, size_t(n));
+    }
+    size_t debut = 0;
+    size_t fin;
+    while ((fin = c->entree.find('\n', debut)) != std::string::npos)
+    {
+        std::string ligne = c->entree.substr(debut, fin - debut);
+        commande_serveur(s, c, &ligne[0]);
+        debut = fin + 1;
+    }
+    c->entree.erase(0, debut);
+    return c->entree.size() < 4096; // ligne sans fin : client fautif
+}
+
+// demon sur une socket unix locale : toutes les parties des clients
+// connectes se partagent une reserve de -threads threads, par tranches de
+// -tranche ms ; le thread principal ne fait que lire et ecrire les sockets
+int mode_serveur(int argc, char **argv)
+{
+    if (argc < 3 || argv[2][0] == '-')
+    {
+        printf("Erreur: chemin de la socket manquant\n");
+        return 1;
+    }
+    const char *chemin = argv[2];
+    OptionsIA opt;
+    options_par_defaut(&opt);
+    opt.algo = "mcts";
+    opt.mcts_mem_mo = 64;
+    if (!lire_options(argc, argv, 3, &opt))
+        return 1;
+    if (strcmp(opt.algo, "mcts") != 0 && strcmp(opt.algo, "ab") != 0 && strcmp(opt.algo, "pvs") != 0)
+    {
+        printf("Erreur: le serveur accepte -algo mcts, ab ou pvs\n");
+        return 1;
+    }
+
+    sockaddr_un adresse;
+    memset(&adresse, 0, sizeof(adresse));
+    adresse.sun_family = AF_UNIX;
+    if (strlen(chemin) >= sizeof(adresse.sun_path))
+    {
+        printf("Erreur: chemin de socket trop long\n");
+        return 1;
+    }
+    strcpy(adresse.sun_path, chemin);
+    struct stat st;
+    if (stat(chemin, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        // socket laissee par un serveur arrete, ou serveur deja actif
+        int essai = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool actif = essai >= 0 && connect(essai, (sockaddr *)&adresse, sizeof(adresse)) == 0;
+        if (essai >= 0)
+            close(essai);
+        if (actif)
+        {
+            fprintf(stderr, "Erreur: un serveur repond deja sur %s\n", chemin);
+            return 1;
+        }
+        unlink(chemin);
+    }
+    int ecoute = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (ecoute < 0 || bind(ecoute, (sockaddr *)&adresse, sizeof(adresse)) < 0 || listen(ecoute, 64) < 0)
+    {
+        fprintf(stderr, "Erreur: socket %s : %s\n", chemin, strerror(errno));
+        return 1;
+    }
+    fcntl(ecoute, F_SETFL, O_NONBLOCK);
+
+    EtatServeur s;
+    s.opt = &opt;
+    s.prochain_client = 1;
+    s.nb_jeux = 0;
+    s.arret = false;
+    s.tt_commune = NULL;
+    s.ponder_touches = 0;
+    s.ponder_rates = 0;
+    s.ponder_gain_us = 0;
+    if (strcmp(opt.algo, "mcts") != 0 && opt.tt_jeu_mo <= 0)
+        s.tt_commune = new TT64_t(log2_table_tt(opt.tt_mo));
+    if (pipe(s.reveil) < 0)
+    {
+        fprintf(stderr, "Erreur: pipe : %s\n", strerror(errno));
+        return 1;
+    }
+    fcntl(s.reveil[0], F_SETFL, O_NONBLOCK);
+    s.reserve = new WorkPool_t(opt.threads);
+    signal(SIGINT, arreter_serveur);
+    signal(SIGTERM, arreter_serveur);
+    signal(SIGPIPE, SIG_IGN);
+    if (opt.verbeux)
+        fprintf(stderr, "serveur: %s algo %s threads %d tranche %.0f ms pas %llu\n", chemin, opt.algo, opt.threads,
+                opt.tranche_ms, opt.pas);
+
+    std::vector<pollfd> fds;
+    std::vector<ClientServeur *> ordre;
+    while (!s.arret && !signal_arret)
+    {
+        fds.clear();
+        ordre.clear();
+        pollfd p;
+        p.fd = ecoute;
+        p.events = POLLIN;
+        fds.push_back(p);
+        p.fd = s.reveil[0];
+        fds.push_back(p);
+        for (std::map<unsigned long long, ClientServeur *>::iterator it = s.clients.begin(); it != s.clients.end(); ++it)
+        {
+            p.fd = it->second->fd;
+            p.events = POLLIN | (it->second->sortie.empty() ? 0 : POLLOUT);
+            fds.push_back(p);
+            ordre.push_back(it->second);
+        }
+        if (poll(&fds[0], fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Erreur: poll : %s\n", strerror(errno));
+            break;
+        }
+        if (fds[1].revents & POLLIN)
+            lire_reponses_serveur(&s);
+        for (size_t i = 0; i < ordre.size(); i++)
+        {
+            ClientServeur *c = ordre[i];
+            bool ouvert = true;
+            if (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR))
+                ouvert = lire_client(&s, c);
+            if (ouvert)
+                ouvert = vider_sortie_client(c);
+            if (!ouvert)
+                fermer_client_serveur(&s, c);
+        }
+        // reponses arrivees pendant ce tour (les nouveaux clients sont servis au suivant)
+        for (std::map<unsigned long long, ClientServeur *>::iterator it = s.clients.begin(); it != s.clients.end();)
+        {
+            ClientServeur *c = (it++)->second;
+            if (!c->sortie.empty() && !vider_sortie_client(c))
+                fermer_client_serveur(&s, c);
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            int fd;
+            while ((fd = accept(ecoute, NULL, NULL)) >= 0)
+            {
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+                ClientServeur *c = new ClientServeur();
+                c->id = s.prochain_client++;
+                c->fd = fd;
+                s.clients[c->id] = c;
+            }
+        }
+    }
+
+    if (opt.verbeux)
+        fprintf(stderr, "serveur: arret, %llu tranches, %llu vols, ponder %llu hit %llu miss gain %.0f ms\n",
+                (unsigned long long)s.reserve->slices, (unsigned long long)s.reserve->steals,
+                (unsigned long long)s.ponder_touches, (unsigned long long)s.ponder_rates, s.ponder_gain_us / 1000.0);
+    while (!s.clients.empty())
+        fermer_client_serveur(&s, s.clients.begin()->second);
+    delete s.reserve; // termine les recherches en cours
+    lire_reponses_serveur(&s);
+    delete s.tt_commune;
+    close(s.reveil[0]);
+    close(s.reveil[1]);
+    close(ecoute);
+    unlink(chemin);
+    afficher_prof(&opt, "serveur");
+    return 0;
+}
 
 void jouer_partie_humain_vs_ia()
 {
@@ -456,17 +1744,54 @@ void afficher_aide()
     printf("BREAKTHROUGH IA\n");
     printf("Usage:\n");
     printf("  %s partie                    # Jouer une partie humain vs IA\n", "breakthrough_simple");
-    printf("  %s <plateau> <joueur>         # Calculer un coup unique\n", "breakthrough_simple");
+    printf("  %s <plateau> <joueur> [options] # Calculer un coup unique\n", "breakthrough_simple");
+    printf("  %s batch [fichier|-] [options]  # Analyser une position par ligne (\"<plateau> <joueur>\")\n", "breakthrough_simple");
+    printf("  %s serveur <socket> [options]   # Demon pour plusieurs parties (mcts par defaut)\n", "breakthrough_simple");
     printf("\nExemples:\n");
     printf("  %s partie\n", "breakthrough_simple");
     printf("  %s 1111111111111111................................0000000000000000 0\n", "breakthrough_simple");
     printf("\nNotation plateau (64 caracteres):\n");
     printf("  1 = pion noir    0 = pion blanc    . = case vide\n");
-    printf("  Joueur: 1 (noir) ou 0 (blanc)\n");
+    printf("  (ou @ = pion noir, O = pion blanc, sans melanger les deux notations)\n");
+    printf("  Joueur: 1 ou @ (noir), 0 ou O (blanc)\n");
+    printf("\nOptions:\n");
+    printf("  -algo flat|hybride|ab|pvs|pns|mcts  algorithme (defaut: flat)\n");
+    printf("                     flat: monte carlo a plat, elimination par moities, sur -threads\n");
+    printf("                     pns: solveur sur tout le temps, puis pvs si non resolu\n");
+    printf("  -temps <ms>        temps de reflexion pour flat/ab/pvs/mcts (defaut: 100 pour flat, 500 sinon)\n");
+    printf("  -prof <n>          profondeur maximale pour ab/pvs (defaut: 64)\n");
+    printf("  -pvs -asp -lmr -verif -qs -sym -pions -see  active une technique (pvs les active toutes sauf see)\n");
+    printf("  -nopvs -noasp -nolmr -noverif -noqs -nosym -nopions -nosee  desactive une technique\n");
+    printf("                     (sym: table de transposition commune aux positions symetriques)\n");
+    printf("                     (pions: evaluation par structure de pions, cache par camp)\n");
+    printf("                     (see: echanges statiques pour l'ordre des prises et les reductions)\n");
+    printf("  -pns <ms>          sonde pns avant ab/pvs (defaut: temps/20 pour pvs, 0 sinon)\n");
+    printf("  -pnsmem <Mo>       memoire de la table du solveur pns (defaut: 64)\n");
+    printf("  -mctsmem <Mo>      memoire de l'arbre mcts, 14 octets par noeud, +8 avec rave, +4 avec motifs (defaut: 256)\n");
+    printf("  -rave <k>          mcts avec rave/amaf, equivalence k (conseille: 100 ; defaut: 0, sans rave)\n");
+    printf("  -motifs            mcts guide par evaluer_patterns_coup : elargissement et biais progressifs\n");
+    printf("  -livre <fichier>   livre d'ouvertures (voir book_builder)\n");
+    printf("  -posdb <fichier>   statistiques des parties par coup sur stderr (voir posdb_builder)\n");
+    printf("  -cache <fichier>   cache de recherche partage entre les appels (cree si absent)\n");
+    printf("  -cachemo <Mo>      taille d'un nouveau cache (defaut: 64)\n");
+    printf("  -threads <n>       flat, batch, serveur: nombre de threads (defaut: nombre de coeurs)\n");
+    printf("  -tranche <ms>      serveur: calcul d'une partie avant de passer a la suivante (defaut: 10)\n");
+    printf("  -pas <n>           serveur: au plus <n> noeuds (ab) ou simulations (mcts) par tranche (defaut: 0)\n");
+    printf("  -ttmo <Mo>         serveur ab/pvs: table de transposition commune (defaut: 256)\n");
+    printf("  -ttjeu <Mo>        serveur ab/pvs: une table par partie au lieu de la table commune\n");
+    printf("  -ponder <ms>       serveur: reflechit sur le temps de l'adversaire, au plus <ms> (defaut: 0)\n");
+    printf("  -pages off|thp|tlb grandes tables en pages de 2 Mo: tlb (MAP_HUGETLB) puis thp (madvise) (defaut: thp)\n");
+    printf("  -numa local|interleave|partition  placement des grandes tables sur les noeuds numa (defaut: local)\n");
+    printf("  -epingler          fixe chaque thread de calcul sur un coeur, en alternant les noeuds numa\n");
+    printf("  -format csv|json   batch: format de sortie (defaut: csv ; batch: -algo ab|pvs, pvs et 100 ms par defaut)\n");
+    printf("  -instr texte|json  resume des compteurs et temps par phase (binaire make PROF=1)\n");
+    printf("  -v                 statistiques de recherche sur stderr\n");
+    printf("  -chrono            instants des etapes du coup unique sur stderr (voir startup_bench)\n");
 }
 
 int main(int argc, char **argv)
 {
+    marquer_chrono(CHRONO_MAIN);
     srand(time(NULL));
 
     if (argc == 1 || (argc == 2 && (strcmp(argv[1], "help") == 0 || strcmp(argv[1], "--help") == 0)))
@@ -481,6 +1806,16 @@ int main(int argc, char **argv)
         return 0;
     }
 
+    if (argc >= 2 && strcmp(argv[1], "batch") == 0)
+    {
+        return mode_batch(argc, argv);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "serveur") == 0)
+    {
+        return mode_serveur(argc, argv);
+    }
+
     if (argc < 3)
     {
         printf("Erreur: Arguments insuffisants\n");
@@ -488,34 +1823,76 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    const char *plateau_str = argv[1];
-    char joueur_char = argv[2][0];
+    Plateau p;
+    int camp;
+    {
+        BK_PROF_SCOPE(PHASE_PARSE);
+        uint64_t blancs, noirs;
+        int erreur = parse_board64(argv[1], blancs, noirs);
+        if (erreur != BOARD_PARSE_OK)
+        {
+            printf("Erreur: plateau invalide (%s).\n", BOARD_PARSE_ERRORS[erreur]);
+            return 1;
+        }
+        plateau_depuis_bitboards(&p, blancs, noirs);
+        camp = parse_side(argv[2]);
+    }
 
-    if (strlen(plateau_str) != 64)
+    if (camp < 0)
     {
-        printf("Erreur: Le plateau doit faire exactement 64 caracteres.\n");
+        printf("Erreur: Joueur doit etre '1' ou '@' (noir), '0' ou 'O' (blanc).\n");
         return 1;
     }
+    Case joueur = camp ? WHITE : BLACK;
 
-    Plateau p;
-    init_plateau(&p, plateau_str);
+    OptionsIA opt;
+    options_par_defaut(&opt);
+    if (!lire_options(argc, argv, 3, &opt))
+    {
+        afficher_aide();
+        return 1;
+    }
+    marquer_chrono(CHRONO_ANALYSE);
 
-    Case joueur;
-    if (joueur_char == '1')
+    Coup c;
+    if (opt.posdb)
+    {
+        rapporter_posdb(&p, joueur, &opt);
+    }
+    if (opt.livre && chercher_coup_livre(&p, joueur, &opt, &c))
+    {
+        marquer_chrono(CHRONO_RECHERCHE);
+        afficher_coup(&c);
+        fflush(stdout);
+        marquer_chrono(CHRONO_SORTIE);
+        if (opt.chrono)
+            afficher_chrono();
+        afficher_prof(&opt, "coup");
+        return 0;
+    }
+    if (strcmp(opt.algo, "ab") == 0 || strcmp(opt.algo, "pvs") == 0 || strcmp(opt.algo, "pns") == 0)
     {
-        joueur = BLACK;
+        c = choisir_coup_alphabeta(&p, joueur, &opt);
     }
-    else if (joueur_char == '0')
+    else if (strcmp(opt.algo, "mcts") == 0)
     {
-        joueur = WHITE;
+        c = choisir_coup_mcts(&p, joueur, &opt);
+    }
+    else if (strcmp(opt.algo, "flat") == 0)
+    {
+        c = choisir_coup_flat(&p, joueur, &opt);
+    }
+    else if (strcmp(opt.algo, "hybride") == 0)
+    {
+        c = choisir_coup_my_algo(&p, joueur);
     }
     else
     {
-        printf("Erreur: Joueur doit etre '1' (noir) ou '0' (blanc).\n");
+        printf("Erreur: algorithme inconnu '%s'\n", opt.algo);
         return 1;
     }
 
-    Coup c = choisir_coup_my_algo(&p, joueur);
+    marquer_chrono(CHRONO_RECHERCHE);
 
     if (c.from.ligne == -1)
     {
@@ -523,7 +1900,15 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    afficher_coup(&c);
+    {
+        BK_PROF_SCOPE(PHASE_OUTPUT);
+        afficher_coup(&c);
+        fflush(stdout);
+    }
+    marquer_chrono(CHRONO_SORTIE);
+    if (opt.chrono)
+        afficher_chrono();
+    afficher_prof(&opt, "coup");
 
     return 0;
 }
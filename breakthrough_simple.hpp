@@ -6,6 +6,27 @@
 #include <time.h>
 #include <string.h>
 #include <vector>
+#include <map>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "bkbb64_search.h"
+#include "bkbb64_pns.h"
+#include "bkbb64_book.h"
+#include "bkbb64_posdb.h"
+#include "bkbb64_mcts.h"
+#include "bkbb64_flat.h"
+#include "bkbb64_pool.h"
+#include "bkbb64_task.h"
 
 enum Case
 {
@@ -31,6 +52,135 @@ struct Plateau
     Case cases[8][8];
 };
 
+struct OptionsIA
+{
+    const char *algo;
+    double temps_ms;
+    int profondeur;
+    bool verbeux;
+    bool chrono;       // coup unique : instants des etapes sur stderr (startup_bench)
+    SearchOptions_t recherche;
+    double pns_ms; // sonde pns avant la recherche (<0 : automatique)
+    int pns_mem_mo;
+    int mcts_mem_mo;   // memoire de l'arbre mcts
+    double rave_k;     // mcts : equivalence rave (0 : sans rave)
+    bool motifs;       // mcts : elargissement et biais progressifs par les motifs tactiques
+    const char *livre; // livre d'ouvertures (NULL : aucun)
+    const char *posdb; // base de positions des parties jouees (NULL : aucune)
+    const char *cache; // cache de recherche persistant (NULL : aucun)
+    int cache_mo;
+    int threads;       // mode batch et serveur
+    bool json;         // mode batch : lignes json au lieu de csv
+    const char *prof;  // resume d'instrumentation : "texte" ou "json" (NULL : aucun)
+    double tranche_ms; // serveur : temps de calcul d'une partie avant de passer a la suivante
+    unsigned long long pas; // serveur : noeuds (ab) ou simulations (mcts) au plus par tranche (0 : tranche_ms seul)
+    int tt_mo;         // serveur : table de transposition commune a toutes les parties
+    int tt_jeu_mo;     // serveur : table propre a chaque partie (0 : table commune)
+    double ponder_ms;  // serveur : reflexion maximale sur le temps de l'adversaire (0 : aucune)
+};
+
+struct PositionBatch
+{
+    char plateau[65];
+    char joueur;
+    bool valide;
+    uint64_t blancs;
+    uint64_t noirs;
+    Move16_t coup;
+    int score;
+    int profondeur;
+    unsigned long long noeuds;
+    double ms;
+};
+
+// partie suivie par le serveur ; pendant une recherche (occupe) seule la
+// tache de la reserve de threads touche a l'arbre et a la recherche
+struct JeuServeur
+{
+    std::string nom;
+    unsigned long long client; // connexion qui a demande le coup
+    Board64_t plateau;
+    bool blanc;
+    double horloge_ms; // temps restant de la partie (<0 : pas d'horloge)
+    double budget_ms;  // temps accorde a la recherche en cours
+    std::chrono::steady_clock::time_point demande;
+    bool occupe;       // recherche en file ou en cours
+    bool supprimer;    // connexion fermee pendant la recherche
+    Mcts64_t *arbre;       // -algo mcts
+    Search64_t *recherche; // -algo ab/pvs
+    AbTask64_t *tache;     // approfondissement de recherche, repris d'une tranche a l'autre
+    unsigned long long tranches;
+    bool nouvelle;     // la premiere tranche reprend l'arbre ou la reflexion
+    std::string info_reprise;
+    // reflexion sur le temps de l'adversaire (-ponder)
+    std::atomic<bool> ponder;      // la tache en cours est une reflexion
+    std::atomic<bool> interrompre; // commande arrivee pour cette partie
+    std::string go_en_attente;     // "go" rejoue a la fin de la reflexion
+    bool reflexion;                // une reflexion a precede la recherche suivante
+    std::chrono::steady_clock::time_point debut_ponder;
+    double ponder_ms;              // temps de calcul de la reflexion
+    uint64_t ponder_iterations;
+    std::vector<uint32_t> visites_avant; // mcts : visites des reponses avant la reflexion
+    Board64_t plateau_ponder;            // ab : position apres la reponse prevue
+    bool blanc_ponder;
+};
+
+struct ClientServeur
+{
+    unsigned long long id;
+    int fd;
+    std::string entree;
+    std::string sortie;
+    std::map<std::string, JeuServeur *> jeux; // noms propres a la connexion
+};
+
+struct ReponseServeur
+{
+    JeuServeur *jeu;
+    std::string ligne;
+    bool fin; // la tache rend la partie au thread principal
+};
+
+struct EtatServeur
+{
+    const OptionsIA *opt;
+    WorkPool_t *reserve;
+    TT64_t *tt_commune;
+    std::map<unsigned long long, ClientServeur *> clients;
+    unsigned long long prochain_client;
+    unsigned long long nb_jeux;
+    bool arret;
+    std::atomic<unsigned long long> ponder_touches;
+    std::atomic<unsigned long long> ponder_rates;
+    std::atomic<unsigned long long> ponder_gain_us; // temps de reflexion utile aux coups joues
+    std::mutex verrou;                     // protege reponses
+    std::vector<ReponseServeur> reponses;  // recherches terminees
+    int reveil[2];                         // tube : un octet par reponse postee
+};
+
+enum TechniqueRecherche
+{
+    TECH_PVS = 1,
+    TECH_ASPIRATION = 2,
+    TECH_LMR = 4,
+    TECH_VERIF = 8,
+    TECH_QUIESCENCE = 16,
+    TECH_SYMETRIE = 32,
+    TECH_PIONS = 64,
+    TECH_SEE = 128
+};
+
+// etapes du mode coup unique mesurees par -chrono
+enum EtapeChrono
+{
+    CHRONO_MAIN = 0,
+    CHRONO_ANALYSE,
+    CHRONO_TABLES,
+    CHRONO_RECHERCHE,
+    CHRONO_SORTIE,
+    CHRONO_NB
+};
+
 struct EvaluationCoup
 {
     Coup coup;
@@ -40,6 +190,7 @@ struct EvaluationCoup
 };
 
 void init_plateau(Plateau *p, const char *str);
+void plateau_depuis_bitboards(Plateau *p, uint64_t blancs, uint64_t noirs);
 void afficher_plateau(const Plateau *p);
 void afficher_coup(const Coup *c);
 bool dans_plateau(int ligne, int col);
@@ -52,6 +203,38 @@ int evaluer(const Plateau *p, Case joueur);
 int evaluer_patterns_coup(Plateau *p, const Coup *c, Case joueur);
 int evaluer_meilleure_riposte(Plateau *p, Case joueur);
 Coup choisir_coup_my_algo(Plateau *p, Case joueur);
+Board64_t plateau_vers_board64(const Plateau *p);
+Coup move16_vers_coup(const Move16_t &m);
+Coup choisir_coup_alphabeta(Plateau *p, Case joueur, const OptionsIA *opt);
+Coup choisir_coup_mcts(Plateau *p, Case joueur, const OptionsIA *opt);
+Coup choisir_coup_flat(Plateau *p, Case joueur, const OptionsIA *opt);
+bool chercher_coup_livre(const Plateau *p, Case joueur, const OptionsIA *opt, Coup *c);
+void rapporter_posdb(const Plateau *p, Case joueur, const OptionsIA *opt);
+void options_par_defaut(OptionsIA *opt);
+bool lire_options(int argc, char **argv, int debut, OptionsIA *opt);
+void appliquer_techniques(SearchOptions_t *r, int activer, int desactiver);
+bool lire_ligne_batch(const char *ligne, PositionBatch *pos);
+void analyser_position_batch(Search64_t *recherche, PositionBatch *pos, const OptionsIA *opt);
+void afficher_prof(const OptionsIA *opt, const char *etiquette);
+void marquer_chrono(int etape);
+void afficher_chrono();
+void ecrire_resultat_batch(FILE *out, unsigned long long id, const PositionBatch *pos, bool json);
+const char *option_hors_batch(const OptionsIA *opt);
+int mode_batch(int argc, char **argv);
+int log2_table_tt(int mo);
+JeuServeur *creer_jeu_serveur(EtatServeur *s, ClientServeur *c, const char *nom);
+void detruire_jeu_serveur(EtatServeur *s, JeuServeur *jeu);
+void poster_reponse_serveur(EtatServeur *s, JeuServeur *jeu, const std::string &ligne, bool fin);
+void commencer_recherche_serveur(EtatServeur *s, JeuServeur *jeu, char *info, size_t taille);
+bool preparer_reflexion_serveur(EtatServeur *s, JeuServeur *jeu, const Move16_t &m);
+bool tranche_serveur(EtatServeur *s, JeuServeur *jeu);
+bool tranche_reflexion_serveur(EtatServeur *s, JeuServeur *jeu);
+void commande_serveur(EtatServeur *s, ClientServeur *c, char *ligne);
+void fermer_client_serveur(EtatServeur *s, ClientServeur *c);
+void lire_reponses_serveur(EtatServeur *s);
+bool vider_sortie_client(ClientServeur *c);
+bool lire_client(EtatServeur *s, ClientServeur *c);
+int mode_serveur(int argc, char **argv);
 void jouer_partie_humain_vs_ia();
 void afficher_aide();
 
@@ -0,0 +1,78 @@
+// plateaux W x H (bkbb64_wh.h) : perft, coups de playout par seconde et
+// recherche alpha-beta pour 5x5, 6x6, 7x7 et 8x8 ; le perft 8x8 est
+// comparé à celui de Board64_t
+// $>./geom_bench [profondeur perft] [ms de recherche]
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include "bkbb64_wh.h"
+
+static
+uint64_t perft64(const Board64_t& _b, int _depth, bool _white) {
+  Lfr_t l = _b.lfr(_white);
+  uint32_t nb = l.nb_moves();
+  if(_depth == 1) return nb;
+  uint64_t n = 0;
+  for(uint32_t i = 0; i < nb; i++) {
+    Board64_t b = _b;
+    b.apply_move(l.get_nth_move(i, _white), _white);
+    n += b.win(_white) ? 1 : perft64(b, _depth-1, !_white);
+  }
+  return n;
+}
+
+// perft (coups générés par seconde : même débit attendu pour toutes les
+// tailles), playouts par seconde, puis une recherche depuis le départ
+template<int W, int H>
+void bench_size(int _perft_depth, double _search_ms) {
+  BoardWH_t<W, H> start;
+  printf("%dx%d\n", W, H);
+  for(int d = 1; d <= _perft_depth; d++) {
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t n = start.perft(d, true);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+    printf("  perft %d %14" PRIu64 "  %6.3f s  %6.1f M/s\n", d, n, s, s > 0.0 ? n/s/1e6 : 0.0);
+  }
+  Rng64_t rng(1ULL);
+  uint64_t nb_playouts = 0;
+  uint64_t white_wins = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  double elapsed = 0.0;
+  while(elapsed < 1.0) {
+    for(int i = 0; i < 1000; i++) {
+      BoardWH_t<W, H> b = start;
+      white_wins += b.seq_playout(true, rng) ? 1 : 0;
+    }
+    nb_playouts += 1000;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  }
+  printf("  playouts %10.0f /s  blancs %.3f\n", nb_playouts/elapsed, double(white_wins)/nb_playouts);
+  SearchWH_t<W, H> search;
+  WhResult_t r = search.think(start, true, 64, _search_ms);
+  printf("  recherche profondeur %d score %d%s noeuds %" PRIu64 " (%.0f k/s)\n", r.depth, r.score,
+         r.solved ? (r.score > 0 ? " (gain prouve)" : " (perte prouvee)") : "", r.nodes,
+         r.ms > 0.0 ? r.nodes/r.ms : 0.0);
+}
+
+int main(int _ac, char** _av) {
+  int depth = _ac > 1 ? atoi(_av[1]) : 6;
+  double search_ms = _ac > 2 ? atof(_av[2]) : 1000.0;
+  bench_size<5, 5>(depth, search_ms);
+  bench_size<6, 6>(depth, search_ms);
+  bench_size<7, 7>(depth, search_ms);
+  bench_size<8, 8>(depth, search_ms);
+
+  // même génération de coups et même débit que Board64_t en 8x8
+  Board64_t b64;
+  Board88_t b88;
+  bool ok = b64.white == b88.white && b64.black == b88.black;
+  for(int d = 1; d < depth && ok; d++) ok = perft64(b64, d, true) == b88.perft(d, true);
+  auto t0 = std::chrono::steady_clock::now();
+  uint64_t n = perft64(b64, depth, true);
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  ok = ok && n == b88.perft(depth, true);
+  printf("Board64_t perft %d %14" PRIu64 "  %6.3f s  %6.1f M/s\n", depth, n, s, n/s/1e6);
+  printf("perft 8x8 identique a Board64_t : %s\n", ok ? "oui" : "NON");
+  return ok ? 0 : 1;
+}
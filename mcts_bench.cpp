@@ -0,0 +1,256 @@
+// comparaison de l'arbre mcts en structure de tableaux (bkbb64_mcts.h) avec
+// une disposition naïve (un objet par noeud avec plateau, coup 128 bits,
+// vecteur de fils et doubles) : octets par noeud et sélections ucb par seconde ;
+// les modes rave et motifs jouent uct contre rave ou contre les motifs
+// (biais et élargissement progressifs) avec moins de playouts par coup
+// $>./mcts_bench [noeuds] [descentes]
+// $>./mcts_bench rave [playouts] [parties] [k] [c]
+// $>./mcts_bench motifs [playouts] [parties] [biais] [k0]
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <malloc.h>
+#include "bkbb64_mcts.h"
+
+struct NaiveNode_t {
+  Board64_t board;
+  Move64_t move;
+  std::vector<NaiveNode_t*> children;
+  double wins;
+  double visits;
+};
+
+static
+size_t heap_bytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return mallinfo2().uordblks;
+#else
+  return size_t(mallinfo().uordblks);
+#endif
+}
+
+static
+void naive_expand(NaiveNode_t* _n, bool _white) {
+  Lfr_t lfr = _n->board.lfr(_white);
+  std::vector<Move64_t> moves = lfr.get_moves(_white);
+  for(size_t i = 0; i < moves.size(); i++) {
+    NaiveNode_t* c = new NaiveNode_t();
+    c->board = _n->board;
+    c->board.apply_move(moves[i], _white);
+    c->move = moves[i];
+    c->wins = 0.0;
+    c->visits = 0.0;
+    _n->children.push_back(c);
+  }
+}
+
+static
+NaiveNode_t* naive_select(const NaiveNode_t* _n, double _c) {
+  double log_n = log(_n->visits+1.0);
+  NaiveNode_t* best = NULL;
+  double best_score = -1.0;
+  for(size_t i = 0; i < _n->children.size(); i++) {
+    NaiveNode_t* c = _n->children[i];
+    double u = c->visits == 0.0 ? 1e9 : c->wins/c->visits+_c*sqrt(log_n/c->visits);
+    if(u > best_score) {
+      best_score = u;
+      best = c;
+    }
+  }
+  return best;
+}
+
+static
+void naive_free(NaiveNode_t* _n) {
+  for(size_t i = 0; i < _n->children.size(); i++) naive_free(_n->children[i]);
+  delete _n;
+}
+
+// descente ucb et développement de la feuille, résultat tiré au hasard à la
+// place du playout : seul le coût de l'arbre est mesuré
+static
+int naive_descend(NaiveNode_t* _root, Rng64_t& _rng, bool _grow, size_t* _nb_nodes) {
+  NaiveNode_t* path[MCTS_MAX_DEPTH];
+  int depth = 0;
+  int nb_select = 0;
+  NaiveNode_t* n = _root;
+  bool white = true;
+  path[depth++] = n;
+  while(!n->board.win(!white)) {
+    if(n->children.empty()) {
+      if(!_grow || n->visits == 0.0) break;
+      naive_expand(n, white);
+      if(n->children.empty()) break;
+      *_nb_nodes += n->children.size();
+    }
+    n = naive_select(n, 0.7);
+    nb_select++;
+    white = !white;
+    path[depth++] = n;
+  }
+  bool won = (_rng.next() & 1) != 0;
+  for(int i = depth-1; i >= 0; i--) {
+    path[i]->visits += 1.0;
+    if(won) path[i]->wins += 1.0;
+    won = !won;
+  }
+  return nb_select;
+}
+
+static
+int soa_descend(Mcts64_t& _t, Rng64_t& _rng, bool _grow) {
+  uint32_t path[MCTS_MAX_DEPTH];
+  int depth = 0;
+  int nb_select = 0;
+  uint32_t id = 0;
+  Board64_t b = _t.root_board;
+  bool white = true;
+  path[depth++] = id;
+  while(!b.win(!white)) {
+    if(_t.nb_children[id] == 0) {
+      if(!_grow || (_t.visits[id] == 0 && id != 0) || !_t.expand(id, b, white)) break;
+    }
+    id = _t.select_child(id);
+    nb_select++;
+    b.apply_move(Move16_t::from_code8(_t.move[id], white));
+    white = !white;
+    path[depth++] = id;
+  }
+  bool won = (_rng.next() & 1) != 0;
+  for(int i = depth-1; i >= 0; i--) {
+    _t.visits[path[i]]++;
+    if(won) _t.wins[path[i]]++;
+    won = !won;
+  }
+  return nb_select;
+}
+
+// réglages d'un joueur mcts : playouts par coup, rave (k = 0 : uct seul)
+// et motifs (biais 0 et k0 0 : sans motifs)
+struct MctsPlayer_t {
+  uint64_t playouts;
+  float rave_k;
+  float c_uct;
+  float pattern_bias;
+  int widen_k0;
+};
+
+// true si _a (blancs quand _a_white) gagne ; deux demi-coups au hasard
+// pour varier les ouvertures
+static
+bool play_game(const MctsPlayer_t& _a, const MctsPlayer_t& _b, bool _a_white, Rng64_t& _rng) {
+  Mcts64_t ta(size_t(64)<<20, _rng.next());
+  Mcts64_t tb(size_t(64)<<20, _rng.next());
+  ta.set_rave(_a.rave_k, _a.c_uct);
+  tb.set_rave(_b.rave_k, _b.c_uct);
+  ta.set_patterns(_a.pattern_bias, _a.widen_k0);
+  tb.set_patterns(_b.pattern_bias, _b.widen_k0);
+  Board64_t b;
+  bool white = true;
+  for(int ply = 0; ; ply++) {
+    Lfr_t lfr = b.lfr(white);
+    if(lfr.nb_moves() == 0) return white != _a_white;
+    if(ply < 2) {
+      b.apply_move(lfr.get_nth_move(_rng.bounded(lfr.nb_moves()), white), white);
+    } else {
+      bool a_turn = (white == _a_white);
+      MctsResult_t r = (a_turn ? ta : tb).think(b, white, 0.0, (a_turn ? _a : _b).playouts);
+      b.apply_move(r.move);
+    }
+    if(b.win(white)) return white == _a_white;
+    white = !white;
+  }
+}
+
+// _player (playouts ignorés) à 1/1, 1/2 et 1/4 des playouts d'uct
+static
+void match(const char* _name, MctsPlayer_t _player, uint64_t _playouts, int _nb_games) {
+  MctsPlayer_t uct = {_playouts, 0.0f, 0.7f, 0.0f, 0};
+  printf("%-12s playouts   victoires  temps par partie\n", _name);
+  for(int div = 1; div <= 4; div *= 2) {
+    _player.playouts = _playouts/div;
+    Rng64_t rng(12345ULL);
+    int won = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for(int g = 0; g < _nb_games; g++) won += play_game(_player, uct, (g & 1) == 0, rng) ? 1 : 0;
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+    printf("%-21" PRIu64 " %3d/%-3d (%2.0f%%)  %.1f s\n", _player.playouts, won, _nb_games,
+           100.0*won/_nb_games, s/_nb_games);
+    fflush(stdout);
+  }
+}
+
+int main(int _ac, char** _av) {
+  if(_ac > 1 && (strcmp(_av[1], "rave") == 0 || strcmp(_av[1], "motifs") == 0)) {
+    uint64_t playouts = _ac > 2 ? uint64_t(atoll(_av[2])) : 4000ULL;
+    int nb_games = _ac > 3 ? atoi(_av[3]) : 40;
+    MctsPlayer_t p = {0, 0.0f, 0.7f, 0.0f, 0};
+    if(strcmp(_av[1], "rave") == 0) {
+      p.rave_k = _ac > 4 ? float(atof(_av[4])) : MCTS_RAVE_K;
+      p.c_uct = _ac > 5 ? float(atof(_av[5])) : MCTS_RAVE_C;
+      printf("uct %" PRIu64 " playouts par coup contre rave (k %.0f c %.2f), %d parties\n", playouts,
+             p.rave_k, p.c_uct, nb_games);
+    } else {
+      p.pattern_bias = _ac > 4 ? float(atof(_av[4])) : MCTS_PATTERN_BIAS;
+      p.widen_k0 = _ac > 5 ? atoi(_av[5]) : MCTS_WIDEN_K0;
+      printf("uct %" PRIu64 " playouts par coup contre motifs (biais %.2f k0 %d), %d parties\n", playouts,
+             p.pattern_bias, p.widen_k0, nb_games);
+    }
+    match(_av[1], p, playouts, nb_games);
+    return 0;
+  }
+  size_t nb_nodes = _ac > 1 ? size_t(atoll(_av[1])) : size_t(2000000);
+  int nb_descents = _ac > 2 ? atoi(_av[2]) : 1000000;
+  Board64_t start;
+
+  // construction jusqu'à nb_nodes noeuds
+  size_t heap0 = heap_bytes();
+  NaiveNode_t* root = new NaiveNode_t();
+  root->board = start;
+  root->wins = root->visits = 0.0;
+  Rng64_t rng_naive(7ULL);
+  size_t naive_nodes = 1;
+  auto t0 = std::chrono::steady_clock::now();
+  while(naive_nodes < nb_nodes) naive_descend(root, rng_naive, true, &naive_nodes);
+  double naive_build = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  size_t naive_bytes = heap_bytes()-heap0;
+
+  // mémoire juste suffisante : reset réserve max_nodes par tableau (+ un
+  // dernier bloc de fils)
+  Mcts64_t tree;
+  tree.set_memory((nb_nodes+MCTS_MAX_CHILDREN)*tree.node_bytes());
+  tree.reset(start, true);
+  Rng64_t rng_soa(7ULL);
+  t0 = std::chrono::steady_clock::now();
+  while(tree.move.size() < nb_nodes) soa_descend(tree, rng_soa, true);
+  double soa_build = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  // capacité réservée (les grands tableaux sont projetés hors du tas)
+  size_t soa_bytes = tree.move.capacity()+tree.nb_children.capacity()+
+                     4*(tree.first_child.capacity()+tree.visits.capacity()+tree.wins.capacity());
+
+  printf("disposition  noeuds     octets/noeud  noeuds/Go     construction\n");
+  printf("naive        %-10zu %-13.1f %-13.0f %.2f s\n", naive_nodes, double(naive_bytes)/naive_nodes,
+         double(1ULL<<30)*naive_nodes/naive_bytes, naive_build);
+  printf("soa          %-10zu %-13.1f %-13.0f %.2f s (%zu octets par noeud utile)\n", tree.move.size(),
+         double(soa_bytes)/tree.move.size(), double(1ULL<<30)*tree.move.size()/soa_bytes, soa_build,
+         tree.node_bytes());
+
+  // sélections ucb par seconde sur l'arbre construit (sans le faire grandir)
+  uint64_t sel = 0;
+  t0 = std::chrono::steady_clock::now();
+  for(int i = 0; i < nb_descents; i++) sel += naive_descend(root, rng_naive, false, &naive_nodes);
+  double naive_sel = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  uint64_t naive_nb_sel = sel;
+  sel = 0;
+  t0 = std::chrono::steady_clock::now();
+  for(int i = 0; i < nb_descents; i++) sel += soa_descend(tree, rng_soa, false);
+  double soa_sel = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  printf("selections   naive %.0f/s  soa %.0f/s  (x%.2f)\n", naive_nb_sel/naive_sel, sel/soa_sel,
+         (sel/soa_sel)/(naive_nb_sel/naive_sel));
+
+  naive_free(root);
+  return 0;
+}
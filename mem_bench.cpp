@@ -0,0 +1,86 @@
+// grandes tables (bkbb64_mem.h) : pour chaque réglage de pages (off, thp,
+// tlb), de numa (local, interleave) et d'épinglage, temps d'allocation et de
+// mise à zéro de la table de transposition, latence d'une sonde (sondes
+// dépendantes, à des adresses aléatoires) et noeuds par seconde de la
+// recherche ; "obtenu" dit ce que le système a vraiment accordé
+// $>./mem_bench [Mo de table] [sondes] [profondeur]
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include "bkbb64_search.h"
+
+// AnonHugePages et Private_Hugetlb du processus, en Mo
+static
+void huge_pages_mb(double& _thp, double& _tlb) {
+  _thp = _tlb = 0.0;
+  FILE* f = fopen("/proc/self/smaps_rollup", "r");
+  if(!f) return;
+  char line[256];
+  while(fgets(line, sizeof(line), f)) {
+    unsigned long kb;
+    if(sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) _thp = kb/1024.0;
+    if(sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1) _tlb = kb/1024.0;
+  }
+  fclose(f);
+}
+
+// _nb sondes où chaque clé dépend de l'entrée lue par la précédente : pas de
+// recouvrement des défauts de cache, on mesure la latence
+static
+double probe_ns(const TT64_t& _tt, uint64_t _nb) {
+  uint64_t key = 0x9e3779b97f4a7c15ULL;
+  uint64_t sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for(uint64_t i = 0; i < _nb; i++) {
+    const TTEntry64_t& e = _tt.table[key & _tt.mask];
+    sink += e.key;
+    key = mix64(key) ^ e.key;
+  }
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  if(sink == 1) printf(" ");
+  return s*1e9/_nb;
+}
+
+int main(int _ac, char** _av) {
+  size_t mb = _ac > 1 ? size_t(atoll(_av[1])) : 1024;
+  uint64_t nb_probes = _ac > 2 ? uint64_t(atoll(_av[2])) : 4000000ULL;
+  int depth = _ac > 3 ? atoi(_av[3]) : 9;
+  int log2 = 0;
+  while((size_t(sizeof(TTEntry64_t))<<(log2+1)) <= (mb<<20)) log2++;
+  printf("table %zu Mo (2^%d entrees), noeuds numa %d, coeurs %zu, %" PRIu64 " sondes, profondeur %d\n",
+         (sizeof(TTEntry64_t)<<log2)>>20, log2, __builtin_popcountll(numa_online_nodes()), pin_cpus().size(),
+         nb_probes, depth);
+  printf("pages numa        epingle  obtenu               alloc ms  sonde ns  noeuds/s\n");
+  cpu_set_t all;
+  CPU_ZERO(&all);
+  sched_getaffinity(0, sizeof(all), &all);
+  Board64_t start;
+  for(int huge = HUGE_OFF; huge <= HUGE_TLB; huge++) {
+    for(int numa = NUMA_LOCAL; numa <= NUMA_INTERLEAVE; numa++) {
+      for(int pin = 0; pin < 2; pin++) {
+        mem_options().huge = huge;
+        mem_options().numa = numa;
+        mem_options().pin = pin != 0;
+        if(!pin_current_thread(0)) sched_setaffinity(0, sizeof(all), &all);
+        uint64_t tlb0 = mem_stats().hugetlb, thp0 = mem_stats().thp, numa0 = mem_stats().numa_placed;
+        auto t0 = std::chrono::steady_clock::now();
+        Search64_t* s = new Search64_t(log2);
+        s->tt.clear(); // la table neuve n'est pas écrite : on paie ici les défauts de page
+        double alloc_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t0).count();
+        double thp_mb, tlb_mb;
+        huge_pages_mb(thp_mb, tlb_mb);
+        char got[32];
+        snprintf(got, sizeof(got), "%s%s %.0f Mo", mem_stats().hugetlb > tlb0 ? "tlb" : (mem_stats().thp > thp0 ? "thp" : "4k"),
+                 mem_stats().numa_placed > numa0 ? "+numa" : "", tlb_mb+thp_mb);
+        double ns = probe_ns(s->tt, nb_probes);
+        SearchResult_t r = s->think(start, true, depth, 0.0);
+        printf("%-5s %-11s %-7s  %-20s %8.0f %9.1f %9.0f\n", HUGE_NAMES[huge], NUMA_NAMES[numa], pin ? "oui" : "non",
+               got, alloc_ms, ns, r.ms > 0.0 ? r.nodes*1000.0/r.ms : 0.0);
+        fflush(stdout);
+        delete s;
+      }
+    }
+  }
+  return 0;
+}
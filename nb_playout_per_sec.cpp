@@ -1,14 +1,175 @@
-#include <cstdlib>   
+#include <cstdlib>
 #include <cstdio>
 #include <cstdint>
+#include <cmath>
 #include <iostream>
 #include <bitset>
 #include <chrono>
+#include <cstring>
+#include <set>
+#include <utility>
 #include "bkbb64.h"
 
+// playouts par seconde depuis la position initiale avec le générateur _rng
+template<class Rng>
+void rng_playout_perf(const char* _name, Rng& _rng) {
+  Board64_t turn0_board;
+  auto begin = std::chrono::steady_clock::now();
+  uint64_t nb_playout = 0ULL;
+  uint64_t nb_white_wins = 0ULL;
+  double elapsed = 0.0;
+  while(elapsed < 1.0) {
+    for(int i = 0; i < 10000; i++) {
+      Board64_t board = turn0_board;
+      board.seq_playout(true, _rng);
+      nb_white_wins += board.white_win() ? 1ULL : 0ULL;
+    }
+    nb_playout += 10000ULL;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now()-begin).count();
+  }
+  fprintf(stderr, "  %-12s %12.0f playouts/s  white wins %.4f\n", _name,
+          double(nb_playout)/elapsed, double(nb_white_wins)/double(nb_playout));
+}
+
+// ancien générateur : Board64_t::seed réensemencé à seed+1 pour chaque playout
+struct LegacySeed_t {
+  uint32_t seed;
+};
+template<>
+void rng_playout_perf<LegacySeed_t>(const char* _name, LegacySeed_t& _rng) {
+  Board64_t turn0_board;
+  auto begin = std::chrono::steady_clock::now();
+  uint64_t nb_playout = 0ULL;
+  uint64_t nb_white_wins = 0ULL;
+  double elapsed = 0.0;
+  while(elapsed < 1.0) {
+    for(int i = 0; i < 10000; i++) {
+      Board64_t board = turn0_board;
+      board.seed = _rng.seed++;
+      board.seq_playout(true);
+      nb_white_wins += board.white_win() ? 1ULL : 0ULL;
+    }
+    nb_playout += 10000ULL;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now()-begin).count();
+  }
+  fprintf(stderr, "  %-12s %12.0f playouts/s  white wins %.4f\n", _name,
+          double(nb_playout)/elapsed, double(nb_white_wins)/double(nb_playout));
+}
+
+// khi-deux de _nb tirages dans [0, _n) : ~ _n-1 attendu, écart-type sqrt(2(_n-1))
+template<class Draw>
+double chi2_bounded(uint32_t _n, uint64_t _nb, Draw _draw) {
+  std::vector<uint64_t> h(_n, 0ULL);
+  for(uint64_t i = 0; i < _nb; i++) h[_draw(_n)]++;
+  double e = double(_nb)/_n;
+  double c = 0.0;
+  for(uint32_t i = 0; i < _n; i++) c += (h[i]-e)*(h[i]-e)/e;
+  return c;
+}
+
+// qualité : uniformité des tirages et indépendance des flux voisins
+// (distance de Hamming moyenne entre premiers tirages, 32 attendus sur 64 bits)
+void rng_quality() {
+  static const uint64_t NB = 20000000ULL;
+  static const uint32_t N = 22; // coups depuis la position initiale
+  uint32_t seed = 1;
+  Rng64_t rng(1ULL);
+  RngBuffer_t buf(1ULL);
+  fprintf(stderr, "chi2 %u cases, %" PRIu64 " tirages (attendu %u +- %.1f)\n", N, NB, N-1, sqrt(2.0*(N-1)));
+  fprintf(stderr, "  xorshift32 %% %10.1f\n", chi2_bounded(N, NB, [&](uint32_t _n) {
+    seed = rand_xorshift(seed); return seed%_n; }));
+  seed = 1;
+  fprintf(stderr, "  xorshift32   %10.1f\n", chi2_bounded(N, NB, [&](uint32_t _n) {
+    return xorshift_bounded(seed, _n); }));
+  fprintf(stderr, "  xoshiro256   %10.1f\n", chi2_bounded(N, NB, [&](uint32_t _n) {
+    return rng.bounded(_n); }));
+  fprintf(stderr, "  batch        %10.1f\n", chi2_bounded(N, NB, [&](uint32_t _n) {
+    return buf.bounded(_n); }));
+
+  static const int NB_STREAMS = 100000;
+  double h_legacy = 0.0;
+  double h_split = 0.0;
+  Rng64_t base(1ULL);
+  Rng64_t prev = base.split();
+  uint64_t prev_first = prev.next();
+  for(int i = 1; i < NB_STREAMS; i++) {
+    h_legacy += __builtin_popcount(rand_xorshift(uint32_t(i)) ^ rand_xorshift(uint32_t(i+1)));
+    Rng64_t cur = base.split();
+    uint64_t first = cur.next();
+    h_split += __builtin_popcountll(first ^ prev_first);
+    prev_first = first;
+  }
+  fprintf(stderr, "flux voisins, hamming moyen du premier tirage\n");
+  fprintf(stderr, "  xorshift32 seed+1 %5.2f / 16\n", h_legacy/(NB_STREAMS-1));
+  fprintf(stderr, "  xoshiro256 split  %5.2f / 32\n", h_split/(NB_STREAMS-1));
+}
+
+// réduction d'origine (état xorshift32 % n) pour comparer la diversité
+struct LegacyModulo_t {
+  uint32_t seed;
+  uint32_t bounded(uint32_t _n) {
+    seed = rand_xorshift(seed);
+    return seed%_n;
+  }
+};
+
+// positions distinctes après _plies demi-coups aléatoires depuis le départ,
+// avec les graines 1.._nb ; le générateur de la graine (Board64_t::seed)
+// et le modulo d'origine
+void first_moves_diversity(int _plies, uint32_t _nb, size_t& _seed_path, size_t& _modulo) {
+  std::set<std::pair<uint64_t, uint64_t> > a, b;
+  for(uint32_t s = 1; s <= _nb; s++) {
+    Board64_t ba;
+    ba.seed = s;
+    Board64_t bb;
+    LegacyModulo_t m = {s};
+    bool white = true;
+    for(int p = 0; p < _plies; p++) {
+      ba.rand_move(white);
+      Lfr_t l = bb.lfr(white);
+      Move64_t mv = bb.get_rand_move(l, white, m);
+      if(white) bb.apply_white_move(mv);
+      else bb.apply_black_move(mv);
+      white = !white;
+    }
+    a.insert(std::make_pair(ba.white, ba.black));
+    b.insert(std::make_pair(bb.white, bb.black));
+  }
+  _seed_path = a.size();
+  _modulo = b.size();
+}
+
+// graines consécutives (b.seed = seed++ dans les bancs et l'auto-jeu) : les
+// premiers coups doivent être au moins aussi variés qu'avec le modulo
+bool check_seed_diversity() {
+  bool ok = true;
+  fprintf(stderr, "positions distinctes, graines 1..200\n");
+  for(int plies = 1; plies <= 2; plies++) {
+    size_t seed_path, modulo;
+    first_moves_diversity(plies, 200, seed_path, modulo);
+    fprintf(stderr, "  %d demi-coup(s)  seed %4zu  modulo %4zu\n", plies, seed_path, modulo);
+    if(seed_path < modulo) ok = false;
+  }
+  if(!ok) fprintf(stderr, "error: Board64_t::seed moins varie que le modulo d'origine\n");
+  return ok;
+}
+
+// $>./nb_playout_per_sec [diversite]
 int main(int _ac, char**_av) {
+  if(_ac > 1 && strcmp(_av[1], "diversite") == 0) return check_seed_diversity() ? 0 : 1;
   print_playout_perf_per_sec(false);
   print_playout_perf_per_sec(false);
+  prof_reset();
   print_playout_perf_per_sec(true);
-  return 0;
+  prof_dump(stderr, false, "nb_playout_per_sec");
+
+  fprintf(stderr, "playouts par generateur\n");
+  LegacySeed_t legacy = {1};
+  Rng64_t rng(1ULL);
+  RngBuffer_t buf(1ULL);
+  rng_playout_perf("xorshift32", legacy);
+  rng_playout_perf("xoshiro256", rng);
+  rng_playout_perf("batch", buf);
+  rng_quality();
+  return check_seed_diversity() ? 0 : 1;
 }
@@ -0,0 +1,437 @@
+// base de positions (bkbb64_posdb.h) : génération de parties d'auto-jeu,
+// construction par tri externe parallèle et requêtes
+// $>./posdb_builder gen PARTIES.txt N [ms par coup] [graine]
+// $>./posdb_builder build BASE PARTIES.txt... [-threads N] [-mem Mo] [-tmp DIR]
+// $>./posdb_builder query BASE [plateau camp]
+// $>./posdb_builder bench BASE [requêtes]
+// une partie par ligne : résultat optionnel ("1-0" blancs, "0-1" noirs)
+// puis les coups ("A2-B3") depuis la position de départ ; sans résultat, le
+// camp qui atteint son but ou prend le dernier pion gagne.
+// build : chaque thread lit sa tranche de chaque fichier et écrit des séries
+// triées d'au plus -mem/threads Mo ; la fusion découpe l'espace des clés en
+// une plage par thread, chaque plage fusionne toutes les séries (projetées
+// en mémoire) dans un fichier partiel, et les parties sont mises bout à bout.
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include "bkbb64_search.h"
+#include "bkbb64_posdb.h"
+
+struct BuildStats_t {
+  std::atomic<uint64_t> games;
+  std::atomic<uint64_t> positions;
+  std::atomic<uint64_t> rejected; // coup illisible ou illégal, partie sans résultat
+  std::atomic<uint64_t> errors;   // fichier illisible, série non écrite : la base serait incomplète
+};
+
+// lignes (clé, coup) d'une partie, victoires remplies à la fin ; false si rejetée
+static
+bool parse_game(const char* _line, std::vector<PosDbEntry_t>& _out) {
+  Board64_t b;
+  bool white = true;
+  int winner = -1; // 1 blancs, 0 noirs
+  size_t first = _out.size();
+  const char* s = _line;
+  char tok[16];
+  int len;
+  while(sscanf(s, " %15s%n", tok, &len) == 1) {
+    s += len;
+    if(strcmp(tok, "1-0") == 0) { winner = 1; continue; }
+    if(strcmp(tok, "0-1") == 0) { winner = 0; continue; }
+    if(b.win(!white)) break; // coups après la fin : ignorés
+    Move16_t m = Move16_t::from_str(tok);
+    if(m.is_null() || m.white() != white) return false;
+    m = b.move16(m.from(), m.dir(), white);
+    if(!b.is_legal(m)) return false;
+    bool mirrored;
+    PosDbEntry_t e;
+    memset(&e, 0, sizeof(e));
+    e.key = b.canonical_hash(white, &mirrored);
+    e.move = (mirrored ? m.mirror() : m).code8();
+    e.games = 1;
+    e.wins = white ? 1 : 0; // camp au trait, remplacé par la victoire
+    _out.push_back(e);
+    b.apply_move(m);
+    if(b.win(white)) winner = white ? 1 : 0;
+    white = !white;
+  }
+  if(winner < 0 || _out.size() == first) {
+    _out.resize(first);
+    return false;
+  }
+  for(size_t i = first; i < _out.size(); i++) _out[i].wins = (int(_out[i].wins) == winner) ? 1 : 0;
+  return true;
+}
+
+struct Run_t {
+  std::string path;
+  uint64_t nb;
+  const PosDbEntry_t* entries;
+  size_t map_size;
+};
+
+static
+bool write_entries(FILE* _f, const PosDbEntry_t* _e, size_t _nb) {
+  return _nb == 0 || fwrite(_e, sizeof(PosDbEntry_t), _nb, _f) == _nb;
+}
+
+// trie et regroupe _buf, l'écrit comme série _k du thread _t et le vide
+static
+void flush_run(std::vector<PosDbEntry_t>& _buf, int _t, int _k, const std::string& _prefix,
+               std::vector<Run_t>& _runs, std::mutex& _lock, BuildStats_t& _stats) {
+  _buf.resize(posdb_aggregate(&_buf[0], _buf.size()));
+  char path[512];
+  snprintf(path, sizeof(path), "%s.%d.%d.run", _prefix.c_str(), _t, _k);
+  FILE* out = fopen(path, "wb");
+  bool ok = out && write_entries(out, &_buf[0], _buf.size());
+  if(out) ok = fclose(out) == 0 && ok;
+  if(!ok) {
+    fprintf(stderr, "error: cannot write %s\n", path);
+    _stats.errors++;
+  }
+  Run_t r;
+  r.path = path;
+  r.nb = ok ? _buf.size() : 0;
+  r.entries = NULL;
+  r.map_size = 0;
+  _buf.clear();
+  std::lock_guard<std::mutex> g(_lock);
+  _runs.push_back(r);
+}
+
+// tranche _t sur _nb de chaque fichier -> séries triées sur disque
+static
+void sort_worker(int _t, int _nb, const std::vector<std::string>& _inputs, size_t _max_entries,
+                 const std::string& _prefix, std::vector<Run_t>& _runs, std::mutex& _lock, BuildStats_t& _stats) {
+  std::vector<PosDbEntry_t> buf;
+  buf.reserve(_max_entries+1024);
+  int nb_runs = 0;
+  std::vector<char> line(1<<16);
+  for(size_t f = 0; f < _inputs.size(); f++) {
+    FILE* in = fopen(_inputs[f].c_str(), "rb");
+    if(!in) {
+      fprintf(stderr, "error: cannot read %s\n", _inputs[f].c_str());
+      _stats.errors++;
+      continue;
+    }
+    fseeko(in, 0, SEEK_END);
+    off_t size = ftello(in);
+    off_t begin = size*_t/_nb;
+    off_t end = size*(_t+1)/_nb;
+    fseeko(in, begin, SEEK_SET);
+    // une ligne commencée avant la tranche appartient à la précédente
+    if(begin > 0) {
+      fseeko(in, begin-1, SEEK_SET);
+      int c;
+      while((c = fgetc(in)) != EOF && c != '\n') {}
+    }
+    while(ftello(in) < end && fgets(&line[0], int(line.size()), in)) {
+      size_t before = buf.size();
+      if(parse_game(&line[0], buf)) {
+        _stats.games++;
+        _stats.positions += buf.size()-before;
+      } else {
+        _stats.rejected++;
+      }
+      if(buf.size() >= _max_entries) flush_run(buf, _t, nb_runs++, _prefix, _runs, _lock, _stats);
+    }
+    if(ferror(in)) {
+      fprintf(stderr, "error: cannot read %s\n", _inputs[f].c_str());
+      _stats.errors++;
+    }
+    fclose(in);
+  }
+  if(!buf.empty()) flush_run(buf, _t, nb_runs++, _prefix, _runs, _lock, _stats);
+}
+
+static
+size_t run_lower_bound(const Run_t& _r, uint64_t _key) {
+  size_t lo = 0, hi = _r.nb;
+  while(lo < hi) {
+    size_t mid = lo+(hi-lo)/2;
+    if(_r.entries[mid].key < _key) lo = mid+1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+struct MergeHead_t {
+  PosDbEntry_t e;
+  size_t run;
+  size_t pos;
+};
+struct MergeGreater_t {
+  bool operator() (const MergeHead_t& _a, const MergeHead_t& _b) const { return posdb_entry_less(_b.e, _a.e); }
+};
+
+// fusion des clés de [_lo, _hi] de toutes les séries dans _path, _nb lignes
+// écrites ; false si le fichier partiel n'a pas pu être écrit en entier
+static
+bool merge_worker(uint64_t _lo, uint64_t _hi, const std::vector<Run_t>& _runs, const std::string& _path,
+                  uint64_t& _nb) {
+  std::priority_queue<MergeHead_t, std::vector<MergeHead_t>, MergeGreater_t> heap;
+  std::vector<size_t> stop(_runs.size());
+  for(size_t r = 0; r < _runs.size(); r++) {
+    size_t begin = run_lower_bound(_runs[r], _lo);
+    stop[r] = _hi == ~0ULL ? _runs[r].nb : run_lower_bound(_runs[r], _hi+1);
+    if(begin < stop[r]) {
+      MergeHead_t h = {_runs[r].entries[begin], r, begin};
+      heap.push(h);
+    }
+  }
+  _nb = 0;
+  FILE* out = fopen(_path.c_str(), "wb");
+  if(!out) {
+    fprintf(stderr, "error: cannot write %s\n", _path.c_str());
+    return false;
+  }
+  std::vector<PosDbEntry_t> buf;
+  buf.reserve(1<<16);
+  bool ok = true;
+  while(!heap.empty()) {
+    MergeHead_t h = heap.top();
+    heap.pop();
+    if(!buf.empty() && posdb_same(buf.back(), h.e)) {
+      buf.back().games += h.e.games;
+      buf.back().wins += h.e.wins;
+    } else {
+      if(buf.size() == buf.capacity()) { // lignes terminées : une autre (clé, coup) arrive
+        ok = write_entries(out, &buf[0], buf.size()) && ok;
+        _nb += buf.size();
+        buf.clear();
+      }
+      buf.push_back(h.e);
+    }
+    if(++h.pos < stop[h.run]) {
+      h.e = _runs[h.run].entries[h.pos];
+      heap.push(h);
+    }
+  }
+  ok = write_entries(out, buf.empty() ? NULL : &buf[0], buf.size()) && ok;
+  _nb += buf.size();
+  ok = fclose(out) == 0 && ok;
+  if(!ok) fprintf(stderr, "error: cannot write %s\n", _path.c_str());
+  return ok;
+}
+
+static
+int build(const char* _db, const std::vector<std::string>& _inputs, int _threads, size_t _mem_mb, const char* _tmp) {
+  auto t0 = std::chrono::steady_clock::now();
+  // une entrée mal nommée est une erreur, pas une base plus petite
+  for(size_t f = 0; f < _inputs.size(); f++) {
+    if(access(_inputs[f].c_str(), R_OK) != 0) {
+      fprintf(stderr, "error: cannot read %s\n", _inputs[f].c_str());
+      return 1;
+    }
+  }
+  std::string prefix = std::string(_tmp)+"/posdb."+std::to_string((long long)getpid());
+  size_t max_entries = (_mem_mb<<20)/sizeof(PosDbEntry_t)/_threads;
+  if(max_entries < 1024) max_entries = 1024;
+  std::vector<Run_t> runs;
+  std::mutex lock;
+  BuildStats_t stats;
+  stats.games = stats.positions = stats.rejected = stats.errors = 0;
+  std::vector<std::thread> threads;
+  for(int t = 0; t < _threads; t++)
+    threads.push_back(std::thread(sort_worker, t, _threads, std::cref(_inputs), max_entries, std::cref(prefix),
+                                  std::ref(runs), std::ref(lock), std::ref(stats)));
+  for(size_t t = 0; t < threads.size(); t++) threads[t].join();
+  threads.clear();
+  double sort_s = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  fprintf(stderr, "%" PRIu64 " games (%" PRIu64 " rejected), %" PRIu64 " positions, %d runs, %.2f s\n",
+          uint64_t(stats.games), uint64_t(stats.rejected), uint64_t(stats.positions), (int)runs.size(), sort_s);
+
+  // une entrée illisible ou une série perdue rendrait la base fausse sans le dire
+  bool ok = stats.errors == 0;
+  for(size_t r = 0; r < runs.size(); r++) {
+    runs[r].map_size = runs[r].nb*sizeof(PosDbEntry_t);
+    if(runs[r].nb == 0) continue;
+    int fd = open(runs[r].path.c_str(), O_RDONLY);
+    void* p = fd < 0 ? MAP_FAILED : mmap(NULL, runs[r].map_size, PROT_READ, MAP_SHARED, fd, 0);
+    if(fd >= 0) close(fd);
+    if(p == MAP_FAILED) {
+      fprintf(stderr, "error: cannot map %s\n", runs[r].path.c_str());
+      ok = false;
+      runs[r].nb = 0;
+      continue;
+    }
+    madvise(p, runs[r].map_size, MADV_SEQUENTIAL);
+    runs[r].entries = (const PosDbEntry_t*)p;
+  }
+  // clés de hachage uniformes : plages de même largeur
+  std::vector<uint64_t> counts(_threads);
+  std::vector<char> merged(_threads);
+  std::vector<std::string> parts(_threads);
+  for(int t = 0; t < _threads; t++) {
+    uint64_t lo = t == 0 ? 0ULL : (~0ULL/_threads)*t+1;
+    uint64_t hi = t+1 == _threads ? ~0ULL : (~0ULL/_threads)*(t+1);
+    parts[t] = prefix+"."+std::to_string((long long)t)+".part";
+    threads.push_back(std::thread([&, t, lo, hi]() { merged[t] = merge_worker(lo, hi, runs, parts[t], counts[t]); }));
+  }
+  for(size_t t = 0; t < threads.size(); t++) threads[t].join();
+  for(int t = 0; t < _threads; t++) ok = merged[t] && ok;
+  for(size_t r = 0; r < runs.size(); r++) {
+    if(runs[r].entries) munmap((void*)runs[r].entries, runs[r].map_size);
+    unlink(runs[r].path.c_str());
+  }
+
+  FILE* out = fopen(_db, "wb");
+  PosDbHeader_t h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, POSDB_MAGIC, 8);
+  for(int t = 0; t < _threads; t++) h.nb_entries += counts[t];
+  h.nb_games = stats.games;
+  ok = out && fwrite(&h, sizeof(h), 1, out) == 1 && ok;
+  std::vector<char> copy(1<<20);
+  for(int t = 0; t < _threads; t++) {
+    FILE* in = fopen(parts[t].c_str(), "rb");
+    uint64_t bytes = 0;
+    size_t n;
+    while(in && ok && (n = fread(&copy[0], 1, copy.size(), in)) > 0) {
+      ok = fwrite(&copy[0], 1, n, out) == n;
+      bytes += n;
+    }
+    // la partie doit contenir exactement les lignes comptées dans l'en-tête
+    ok = in && !ferror(in) && bytes == counts[t]*sizeof(PosDbEntry_t) && ok;
+    if(in) fclose(in);
+    unlink(parts[t].c_str());
+  }
+  if(out) ok = fclose(out) == 0 && ok;
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  if(!ok) {
+    fprintf(stderr, "error: cannot build %s\n", _db);
+    if(out) unlink(_db); // pas de base tronquée à la place de l'ancienne
+    return 1;
+  }
+  fprintf(stderr, "%" PRIu64 " entries written to %s, merge %.2f s, total %.2f s (%.1f M positions/s)\n",
+          h.nb_entries, _db, s-sort_s, s, s > 0.0 ? stats.positions/s/1e6 : 0.0);
+  return 0;
+}
+
+// auto-jeu : aléatoire si _ms == 0, sinon recherche de _ms par coup après
+// six demi-coups aléatoires
+static
+int gen(const char* _path, int _nb, double _ms, uint32_t _seed) {
+  FILE* out = fopen(_path, "w");
+  if(!out) {
+    fprintf(stderr, "error: cannot write %s\n", _path);
+    return 1;
+  }
+  Search64_t* s = new Search64_t(18);
+  s->opt = SearchOptions_t::all();
+  s->opt.pawn_eval = true;
+  for(int g = 0; g < _nb; g++) {
+    Board64_t b;
+    b.seed = _seed+g;
+    bool white = true;
+    std::string line;
+    for(int ply = 0; ply < 300; ply++) {
+      Move16_t m;
+      if(b.lfr(white).nb_moves() == 0) break;
+      if(_ms <= 0.0 || ply < 6) {
+        Move64_t r = b.get_rand_move(white);
+        m = Move16_t::from_squares(__builtin_ctzll(r.pi), __builtin_ctzll(r.pf));
+        m = b.move16(m.from(), m.dir(), white);
+      } else {
+        m = s->think(b, white, MAX_PLY-2, _ms).move;
+      }
+      line += (line.empty() ? "" : " ")+m.to_str();
+      b.apply_move(m);
+      if(b.win(white)) break;
+      white = !white;
+    }
+    fprintf(out, "%s\n", line.c_str());
+  }
+  delete s;
+  return fclose(out) == 0 ? 0 : 1;
+}
+
+static
+void print_moves(const PosDb_t& _db, const Board64_t& _b, bool _white) {
+  std::vector<PosDbMove_t> moves;
+  uint32_t total = _db.find(_b, _white, moves);
+  std::sort(moves.begin(), moves.end(), [](const PosDbMove_t& _x, const PosDbMove_t& _y) { return _x.games > _y.games; });
+  printf("%u games\n", total);
+  for(size_t i = 0; i < moves.size(); i++)
+    printf("%s %8u games %5.1f%% wins\n", moves[i].move.to_str().c_str(), moves[i].games,
+           100.0*moves[i].wins/moves[i].games);
+}
+
+// requêtes sur des positions tirées de parties aléatoires
+static
+void bench(const PosDb_t& _db, int _nb) {
+  std::vector<Board64_t> boards;
+  std::vector<bool> sides;
+  for(uint32_t seed = 1; (int)boards.size() < _nb; seed++) {
+    Board64_t b;
+    b.seed = seed;
+    bool white = true;
+    for(int ply = 0; ply < int(seed%12) && !b.win(!white); ply++) {
+      b.rand_move(white);
+      white = !white;
+    }
+    boards.push_back(b);
+    sides.push_back(white);
+  }
+  std::vector<PosDbMove_t> moves;
+  uint64_t found = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < boards.size(); i++)
+    if(_db.find(boards[i], sides[i], moves) > 0) found++;
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+  printf("%d lookups, %" PRIu64 " found, %.2f us/lookup, %" PRIu64 " entries\n", _nb, found, s*1e6/_nb,
+         _db.header->nb_entries);
+}
+
+int main(int _ac, char** _av) {
+  if(_ac >= 4 && strcmp(_av[1], "gen") == 0)
+    return gen(_av[2], atoi(_av[3]), _ac > 4 ? atof(_av[4]) : 0.0, _ac > 5 ? uint32_t(atoll(_av[5])) : 1);
+  if(_ac >= 4 && strcmp(_av[1], "build") == 0) {
+    std::vector<std::string> inputs;
+    int threads = int(std::thread::hardware_concurrency());
+    size_t mem_mb = 1024;
+    const char* tmp = ".";
+    for(int i = 3; i < _ac; i++) {
+      if(strcmp(_av[i], "-threads") == 0 && i+1 < _ac) threads = atoi(_av[++i]);
+      else if(strcmp(_av[i], "-mem") == 0 && i+1 < _ac) mem_mb = size_t(atoll(_av[++i]));
+      else if(strcmp(_av[i], "-tmp") == 0 && i+1 < _ac) tmp = _av[++i];
+      else inputs.push_back(_av[i]);
+    }
+    if(threads < 1) threads = 1;
+    return build(_av[2], inputs, threads, mem_mb, tmp);
+  }
+  if(_ac >= 3 && (strcmp(_av[1], "query") == 0 || strcmp(_av[1], "bench") == 0)) {
+    PosDb_t db;
+    if(!db.open(_av[2])) {
+      fprintf(stderr, "error: cannot open %s\n", _av[2]);
+      return 1;
+    }
+    if(strcmp(_av[1], "bench") == 0) {
+      bench(db, _ac > 3 ? atoi(_av[3]) : 1000000);
+      return 0;
+    }
+    Board64_t b;
+    bool white = true;
+    if(_ac > 4) {
+      if(b.parse(_av[3], strlen(_av[3])) != BOARD_PARSE_OK || parse_side(_av[4]) < 0) {
+        fprintf(stderr, "error: bad board or side\n");
+        return 1;
+      }
+      white = parse_side(_av[4]) == 1;
+    }
+    print_moves(db, b, white);
+    return 0;
+  }
+  fprintf(stderr, "usage: %s gen GAMES N [MS] [SEED]\n"
+                  "       %s build DB GAMES... [-threads N] [-mem MB] [-tmp DIR]\n"
+                  "       %s query DB [BOARD SIDE]\n"
+                  "       %s bench DB [LOOKUPS]\n", _av[0], _av[0], _av[0], _av[0]);
+  return 1;
+}
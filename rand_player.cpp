@@ -28,15 +28,17 @@ int main(int _ac, char** _av) {
     fprintf(stderr, "usage: %s BOARD PLAYER\n", _av[0]);
     return 0;
   }
-  Board64_t B(_av[1]);
+  Board64_t B;
+  int err = B.parse(_av[1], strlen(_av[1]));
+  int side = parse_side(_av[2]);
+  if(err != BOARD_PARSE_OK || side < 0) {
+    fprintf(stderr, "error: %s\n", err != BOARD_PARSE_OK ? BOARD_PARSE_ERRORS[err] : "PLAYER must be O/0 or @/1");
+    return 1;
+  }
   bool debug = false;
   if(debug) {
     B.print_board(stderr);
   }
-  if(std::string(_av[2]).compare("O")==0) {
-    printf("%s\n", genmove(B, WHITE).c_str());
-  } else if(std::string(_av[2]).compare("@")==0) {
-    printf("%s\n", genmove(B, BLACK).c_str());
-  }
+  printf("%s\n", genmove(B, side ? WHITE : BLACK).c_str());
   return 0;
 }
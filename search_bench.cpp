@@ -0,0 +1,231 @@
+// mesure de l'effet de chaque technique de recherche (pvs, aspiration, lmr)
+// (et de la quiescence) sur le temps pour atteindre une profondeur et sur
+// les résultats en match ; puis évaluations par seconde avec et sans le
+// cache de structure de pions, et match de l'évaluation par structure ;
+// see vérifié contre une recherche exhaustive des reprises, et mesuré en match
+// $>./search_bench [profondeur] [parties] [ms par coup]
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include "bkbb64_search.h"
+
+struct BenchConfig_t {
+  const char* name;
+  SearchOptions_t opt;
+};
+
+// positions de test : départ puis quelques ouvertures aléatoires de 16
+// demi-coups, toutes avec les blancs au trait
+std::vector<Board64_t> bench_positions(int _nb) {
+  std::vector<Board64_t> ret;
+  ret.push_back(Board64_t());
+  uint32_t seed = 12345;
+  while((int)ret.size() < _nb) {
+    Board64_t b;
+    b.seed = seed++;
+    bool white = true;
+    bool ok = true;
+    for(int ply = 0; ply < 16 && ok; ply++) {
+      b.rand_move(white);
+      if(b.win(white)) ok = false;
+      white = !white;
+    }
+    if(ok) ret.push_back(b);
+  }
+  return ret;
+}
+
+// feuilles d'un parcours en profondeur, dans l'ordre où une recherche les
+// évalue : entre deux feuilles sœurs un seul camp a bougé (sauf prise)
+void collect_leaves(const Board64_t& _b, bool _white, int _depth, std::vector<Board64_t>& _out) {
+  if(_depth == 0 || _b.win(!_white)) {
+    _out.push_back(_b);
+    return;
+  }
+  MoveList64_t l;
+  gen_moves(_b, _white, l);
+  for(int i = 0; i < l.size; i++) {
+    Board64_t child = _b;
+    child.apply_move(l.moves[i].move);
+    collect_leaves(child, !_white, _depth-1, _out);
+  }
+}
+
+// évaluations par seconde : barème simple, structure sans cache, avec cache
+void bench_eval(const std::vector<Board64_t>& _positions) {
+  std::vector<Board64_t> leaves;
+  for(size_t p = 0; p < _positions.size(); p++) collect_leaves(_positions[p], true, 4, leaves);
+  const int rounds = 10;
+  const char* names[3] = {"eval_bb", "pawns no cache", "pawns cache"};
+  PawnCache64_t* cache = new PawnCache64_t();
+  uint64_t hits = 0;
+  printf("%-16s %12s %10s %8s\n", "eval", "evals", "M/s", "hits");
+  for(int k = 0; k < 3; k++) {
+    int64_t sum = 0;
+    hits = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for(int r = 0; r < rounds; r++) {
+      cache->clear(); // chaque tour part d'un cache vide comme une recherche
+      for(size_t i = 0; i < leaves.size(); i++) {
+        if(k == 0) sum += eval_bb(leaves[i], true);
+        else if(k == 1) sum += eval_pawns_full(leaves[i], true);
+        else sum += eval_pawns(leaves[i], true, *cache, hits);
+      }
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+    uint64_t n = uint64_t(rounds)*leaves.size();
+    printf("%-16s %12" PRIu64 " %10.1f", names[k], n, n/s/1e6);
+    if(k == 2) printf(" %7.1f%%", 100.0*hits/(2*n));
+    printf("%s\n", sum == 1 ? " " : "");
+  }
+  delete cache;
+}
+
+// gain, pour le camp qui vient de jouer sur _sq, de la suite des reprises
+// (chaque camp peut reprendre avec n'importe quel attaquant ou s'arrêter)
+int exchange(const Board64_t& _b, int _sq, bool _white) {
+  uint64_t att = pawn_attackers(_white ? _b.black : _b.white, 1ULL<<_sq, !_white);
+  int best = 0;
+  while(att) {
+    int from = __builtin_ctzll(att);
+    att &= att-1;
+    int dir = (_sq-from == dir_delta(DIR_LEFT, !_white)) ? DIR_LEFT : DIR_RIGHT;
+    Board64_t b = _b;
+    b.apply_move(Move16_t::make(from, dir, !_white, true));
+    int g = 1+exchange(b, _sq, !_white);
+    if(g > best) best = g;
+  }
+  return -best;
+}
+
+// see contre exchange sur tous les coups de positions de milieu de partie
+void check_see() {
+  uint64_t nb = 0, bad = 0;
+  for(uint32_t seed = 1; seed <= 2000; seed++) {
+    Board64_t b;
+    b.seed = seed;
+    bool white = true;
+    for(int ply = 0; ply < 20 && !b.win(!white); ply++) {
+      b.rand_move(white);
+      white = !white;
+    }
+    if(b.win(!white)) continue;
+    MoveList64_t l;
+    gen_moves(b, white, l);
+    for(int i = 0; i < l.size; i++) {
+      const Move16_t& m = l.moves[i].move;
+      Board64_t c = b;
+      c.apply_move(m);
+      int ref = (m.capture() ? 1 : 0)+exchange(c, m.to(), white);
+      nb++;
+      if(see(b, m) != ref) bad++;
+    }
+  }
+  printf("see: %" PRIu64 " coups, %" PRIu64 " differences avec la recherche des reprises\n", nb, bad);
+}
+
+// partie entre deux réglages, renvoie true si _a (blancs si _a_white) gagne
+bool play_game(const SearchOptions_t& _a, const SearchOptions_t& _b, bool _a_white,
+               const Board64_t& _start, double _ms) {
+  Search64_t sa(18), sb(18);
+  sa.opt = _a;
+  sb.opt = _b;
+  Board64_t board = _start;
+  bool white = true;
+  for(int ply = 0; ply < 300; ply++) {
+    MoveList64_t l;
+    gen_moves(board, white, l);
+    if(l.size == 0) return (white != _a_white);
+    Search64_t& s = (white == _a_white) ? sa : sb;
+    SearchResult_t r = s.think(board, white, MAX_PLY-2, _ms);
+    board.apply_move(r.move);
+    if(board.win(white)) return (white == _a_white);
+    white = !white;
+  }
+  return false;
+}
+
+int main(int _ac, char** _av) {
+  int depth = _ac > 1 ? atoi(_av[1]) : 8;
+  int nb_games = _ac > 2 ? atoi(_av[2]) : 10;
+  double ms = _ac > 3 ? atof(_av[3]) : 20.0;
+
+  std::vector<BenchConfig_t> configs;
+  BenchConfig_t c;
+  c.name = "plain"; c.opt = SearchOptions_t(); configs.push_back(c);
+  c.name = "pvs"; c.opt.pvs = true; configs.push_back(c);
+  c.name = "pvs+asp"; c.opt.aspiration = true; configs.push_back(c);
+  c.name = "lmr(no verif)"; c.opt = SearchOptions_t(); c.opt.lmr = true; configs.push_back(c);
+  c.name = "pvs+lmr+verif"; c.opt = SearchOptions_t::all(); c.opt.aspiration = false;
+  c.opt.quiescence = false; configs.push_back(c);
+  c.name = "quiescence"; c.opt = SearchOptions_t(); c.opt.quiescence = true; configs.push_back(c);
+  c.name = "all"; c.opt = SearchOptions_t::all(); configs.push_back(c);
+
+  std::vector<Board64_t> positions = bench_positions(6);
+  printf("time to depth %d on %d positions, %d games vs plain at %.0f ms/move\n",
+         depth, (int)positions.size(), nb_games, ms);
+  printf("%-16s %12s %10s %8s\n", "config", "nodes", "ms", "score");
+  for(size_t i = 0; i < configs.size(); i++) {
+    uint64_t nodes = 0ULL;
+    double total_ms = 0.0;
+    for(size_t p = 0; p < positions.size(); p++) {
+      Search64_t s(20);
+      s.opt = configs[i].opt;
+      SearchResult_t r = s.think(positions[p], true, depth, 0.0);
+      nodes += r.nodes;
+      total_ms += r.ms;
+    }
+    int wins = 0;
+    if(i > 0) {
+      for(int g = 0; g < nb_games; g++) {
+        const Board64_t& start = positions[(g/2)%positions.size()];
+        if(play_game(configs[i].opt, configs[0].opt, g%2 == 0, start, ms)) wins++;
+      }
+    }
+    printf("%-16s %12" PRIu64 " %10.1f", configs[i].name, nodes, total_ms);
+    if(i > 0) printf(" %4d/%-4d", wins, nb_games);
+    printf("\n");
+  }
+
+  bench_eval(positions);
+  SearchOptions_t pawn = SearchOptions_t::all();
+  pawn.pawn_eval = true;
+  uint64_t nodes = 0ULL, hits = 0ULL, probes = 0ULL;
+  double total_ms = 0.0;
+  for(size_t p = 0; p < positions.size(); p++) {
+    Search64_t s(20);
+    s.opt = pawn;
+    SearchResult_t r = s.think(positions[p], true, depth, 0.0);
+    nodes += r.nodes;
+    total_ms += r.ms;
+    hits += s.stats.pawn_hits;
+    probes += s.stats.pawn_probes;
+  }
+  int wins = 0;
+  for(int g = 0; g < nb_games; g++) {
+    const Board64_t& start = positions[(g/2)%positions.size()];
+    if(play_game(pawn, configs.back().opt, g%2 == 0, start, ms)) wins++;
+  }
+  printf("%-16s %12" PRIu64 " %10.1f %4d/%-4d vs all, pawn cache hits %.1f%%\n", "all+pawns", nodes, total_ms,
+         wins, nb_games, probes ? 100.0*hits/probes : 0.0);
+
+  check_see();
+  SearchOptions_t with_see = pawn;
+  with_see.see = true;
+  nodes = 0ULL;
+  total_ms = 0.0;
+  for(size_t p = 0; p < positions.size(); p++) {
+    Search64_t s(20);
+    s.opt = with_see;
+    SearchResult_t r = s.think(positions[p], true, depth, 0.0);
+    nodes += r.nodes;
+    total_ms += r.ms;
+  }
+  wins = 0;
+  for(int g = 0; g < nb_games; g++) {
+    const Board64_t& start = positions[(g/2)%positions.size()];
+    if(play_game(with_see, pawn, g%2 == 0, start, ms)) wins++;
+  }
+  printf("%-16s %12" PRIu64 " %10.1f %4d/%-4d vs all+pawns\n", "all+pawns+see", nodes, total_ms, wins, nb_games);
+  return 0;
+}
@@ -0,0 +1,174 @@
+// latence à froid du mode coup unique, comme la mesure le pont Ludii : du
+// lancement du processus à la première ligne écrite sur stdout. Chaque
+// binaire est lancé plusieurs fois sur chaque position avec -chrono, qui
+// écrit sur stderr, après la réponse, les instants (CLOCK_MONOTONIC) de
+// l'entrée dans main, de la fin de l'analyse des arguments, des tables
+// prêtes, de la fin de la recherche et de la réponse écrite. Le démarrage
+// (fork/exec, chargeur dynamique, initialisations statiques) est l'écart
+// entre le lancement et l'entrée dans main.
+// $>./startup_bench [lancements par position] [positions] <binaire>... [-- options des binaires]
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <spawn.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "bkbb64.h"
+#include "bkbb64_notation.h"
+
+extern char** environ;
+
+static
+int64_t now_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return int64_t(ts.tv_sec)*1000000000LL+ts.tv_nsec;
+}
+
+// positions de test : départ puis quelques ouvertures aléatoires de 16
+// demi-coups, toutes avec les blancs au trait
+std::vector<Board64_t> bench_positions(int _nb) {
+  std::vector<Board64_t> ret;
+  ret.push_back(Board64_t());
+  uint32_t seed = 12345;
+  while((int)ret.size() < _nb) {
+    Board64_t b;
+    b.seed = seed++;
+    bool white = true;
+    bool ok = true;
+    for(int ply = 0; ply < 16 && ok; ply++) {
+      b.rand_move(white);
+      if(b.win(white)) ok = false;
+      white = !white;
+    }
+    if(ok) ret.push_back(b);
+  }
+  return ret;
+}
+
+// étapes mesurées, dans l'ordre : chacune est l'écart avec la précédente,
+// sauf les deux dernières comptées depuis le lancement
+enum { STEP_STARTUP = 0, STEP_PARSE, STEP_TABLES, STEP_SEARCH, STEP_OUTPUT, STEP_ANSWER, STEP_EXIT, STEP_NB };
+static const char* STEP_NAMES[STEP_NB] = {"startup", "parse", "tables", "search", "output", "answer", "exit"};
+
+// un lancement ; false si le binaire n'a pas répondu ou pas écrit ses instants
+bool run_once(const std::vector<std::string>& _args, double* _us) {
+  int out[2], err[2];
+  if(pipe(out) != 0 || pipe(err) != 0) return false;
+  posix_spawn_file_actions_t fa;
+  posix_spawn_file_actions_init(&fa);
+  posix_spawn_file_actions_adddup2(&fa, out[1], 1);
+  posix_spawn_file_actions_adddup2(&fa, err[1], 2);
+  posix_spawn_file_actions_addclose(&fa, out[0]);
+  posix_spawn_file_actions_addclose(&fa, err[0]);
+  std::vector<char*> argv;
+  for(size_t i = 0; i < _args.size(); i++) argv.push_back((char*)_args[i].c_str());
+  argv.push_back(NULL);
+  pid_t pid;
+  int64_t t0 = now_ns();
+  int rc = posix_spawn(&pid, argv[0], &fa, NULL, &argv[0], environ);
+  posix_spawn_file_actions_destroy(&fa);
+  close(out[1]);
+  close(err[1]);
+  if(rc != 0) {
+    close(out[0]);
+    close(err[0]);
+    return false;
+  }
+  // première ligne de stdout : la réponse attendue par le pont
+  std::string line;
+  char buf[256];
+  int64_t t_answer = 0;
+  ssize_t n;
+  while(!t_answer && (n = read(out[0], buf, sizeof(buf))) > 0) {
+    line.append(buf, n);
+    if(line.find('\n') != std::string::npos) t_answer = now_ns();
+  }
+  while(read(out[0], buf, sizeof(buf)) > 0) {}
+  std::string diag;
+  while((n = read(err[0], buf, sizeof(buf))) > 0) diag.append(buf, n);
+  int status;
+  waitpid(pid, &status, 0);
+  int64_t t_exit = now_ns();
+  close(out[0]);
+  close(err[0]);
+  long long t[5];
+  size_t pos = diag.find("chrono ");
+  if(!t_answer || pos == std::string::npos ||
+     sscanf(diag.c_str()+pos, "chrono main %lld analyse %lld tables %lld recherche %lld sortie %lld",
+            &t[0], &t[1], &t[2], &t[3], &t[4]) != 5)
+    return false;
+  _us[STEP_STARTUP] = (t[0]-t0)/1e3;
+  for(int i = 1; i < 5; i++) _us[i] = (t[i]-t[i-1])/1e3;
+  _us[STEP_ANSWER] = (t_answer-t0)/1e3;
+  _us[STEP_EXIT] = (t_exit-t0)/1e3;
+  return true;
+}
+
+// _v trié
+static
+double percentile(const std::vector<double>& _v, int _p) {
+  size_t i = _v.size()*_p/100;
+  return _v[i < _v.size() ? i : _v.size()-1];
+}
+
+int main(int _ac, char** _av) {
+  int runs = _ac > 1 ? atoi(_av[1]) : 20;
+  int nb_positions = _ac > 2 ? atoi(_av[2]) : 10;
+  std::vector<std::string> binaries, options;
+  int i = 3;
+  for(; i < _ac && strcmp(_av[i], "--") != 0; i++) binaries.push_back(_av[i]);
+  for(i++; i < _ac; i++) options.push_back(_av[i]);
+  if(binaries.empty()) binaries.push_back("./breakthrough_simple");
+  if(options.empty()) {
+    options.push_back("-algo");
+    options.push_back("pvs");
+    options.push_back("-temps");
+    options.push_back("50");
+  }
+
+  std::vector<Board64_t> positions = bench_positions(nb_positions);
+  std::string opts;
+  for(size_t k = 0; k < options.size(); k++) opts += " "+options[k];
+  printf("%d launches on each of %d positions, options%s\n", runs, (int)positions.size(), opts.c_str());
+  for(size_t b = 0; b < binaries.size(); b++) {
+    std::vector<std::vector<double> > steps(STEP_NB);
+    int failures = 0;
+    // une passe par lancement, les positions alternées : le cache de pages
+    // et les fréquences sont les mêmes pour toutes
+    for(int r = 0; r < runs; r++) {
+      for(size_t p = 0; p < positions.size(); p++) {
+        char board[65];
+        format_board64(positions[p].white, positions[p].black, ALPHABET_SYMBOLS, board);
+        board[64] = '\0';
+        std::vector<std::string> args;
+        args.push_back(binaries[b]);
+        args.push_back(board);
+        args.push_back("O");
+        args.insert(args.end(), options.begin(), options.end());
+        args.push_back("-chrono");
+        double us[STEP_NB];
+        if(!run_once(args, us)) {
+          failures++;
+          continue;
+        }
+        for(int s = 0; s < STEP_NB; s++) steps[s].push_back(us[s]);
+      }
+    }
+    printf("\n%s: %zu launches, %d failed\n", binaries[b].c_str(), steps[0].size(), failures);
+    if(steps[0].empty()) continue;
+    printf("%-8s %10s %10s %10s\n", "step", "p50 us", "p99 us", "max us");
+    for(int s = 0; s < STEP_NB; s++) {
+      std::sort(steps[s].begin(), steps[s].end());
+      printf("%-8s %10.0f %10.0f %10.0f\n", STEP_NAMES[s], percentile(steps[s], 50), percentile(steps[s], 99),
+             steps[s].back());
+    }
+    fflush(stdout);
+  }
+  return 0;
+}
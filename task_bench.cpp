@@ -0,0 +1,192 @@
+// recherches reprenables (bkbb64_task.h) : d'abord l'alpha-beta par pas
+// comparé à Search64_t::think (même coup, même score, mêmes noeuds, pour des
+// pas de taille quelconque), puis de nombreuses parties entrelacées sur
+// quelques threads par la réserve du serveur (WorkPool_t) : latence de
+// chaque pas (p50/p99/max) quand un pas est une profondeur entière (comme
+// Search64_t::step) ou un nombre borné de noeuds ou de simulations
+// $>./task_bench [parties] [threads] [profondeur] [noeuds par pas] [simulations par pas]
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "bkbb64_task.h"
+#include "bkbb64_pool.h"
+
+// positions de test : départ puis quelques ouvertures aléatoires de 16
+// demi-coups, toutes avec les blancs au trait
+std::vector<Board64_t> bench_positions(int _nb) {
+  std::vector<Board64_t> ret;
+  ret.push_back(Board64_t());
+  uint32_t seed = 12345;
+  while((int)ret.size() < _nb) {
+    Board64_t b;
+    b.seed = seed++;
+    bool white = true;
+    bool ok = true;
+    for(int ply = 0; ply < 16 && ok; ply++) {
+      b.rand_move(white);
+      if(b.win(white)) ok = false;
+      white = !white;
+    }
+    if(ok) ret.push_back(b);
+  }
+  return ret;
+}
+
+// la tâche doit dérouler exactement la recherche récursive, quelle que soit
+// la taille des pas
+int check_task(const std::vector<Board64_t>& _positions, int _depth) {
+  const char* names[3] = {"plain", "all", "all+pawns+see"};
+  SearchOptions_t opts[3];
+  opts[1] = SearchOptions_t::all();
+  opts[2] = SearchOptions_t::all();
+  opts[2].pawn_eval = opts[2].see = true;
+  const uint64_t sizes[4] = {1, 7, 1000, 0};
+  int errors = 0;
+  for(int c = 0; c < 3; c++) {
+    uint64_t nodes = 0, steps = 0;
+    for(size_t p = 0; p < _positions.size(); p++) {
+      bool white = true;
+      Search64_t* ref = new Search64_t(16);
+      ref->opt = opts[c];
+      SearchResult_t r = ref->think(_positions[p], white, _depth, 0.0);
+      delete ref;
+      for(int k = 0; k < 4; k++) {
+        Search64_t* s = new Search64_t(16);
+        s->opt = opts[c];
+        AbTask64_t t(*s);
+        t.start(_positions[p], white, _depth, 0.0);
+        while(t.step(sizes[k])) steps++;
+        if(t.res.move != r.move || t.res.score != r.score || t.res.depth != r.depth || t.res.nodes != r.nodes) {
+          printf("  %s position %zu step %" PRIu64 ": task %s %d %" PRIu64 " think %s %d %" PRIu64 "\n",
+                 names[c], p, sizes[k], t.res.move.to_str().c_str(), t.res.score, t.res.nodes,
+                 r.move.to_str().c_str(), r.score, r.nodes);
+          errors++;
+        }
+        delete s;
+      }
+      nodes += r.nodes;
+    }
+    printf("%-14s %10" PRIu64 " nodes %8" PRIu64 " steps\n", names[c], nodes, steps);
+  }
+  printf("differences: %d\n", errors);
+  return errors;
+}
+
+// une partie du banc : sa recherche et les durées de ses pas
+struct BenchGame_t {
+  Board64_t board;
+  bool white;
+  Search64_t* search;
+  AbTask64_t* task;
+  Mcts64_t* tree;
+  MctsTask64_t* mcts;
+  SearchResult_t res;
+  int depth;
+  std::vector<float> steps_us;
+};
+
+enum { MODE_DEPTH = 0, MODE_NODES, MODE_MCTS };
+
+// un pas de la partie _g selon _mode ; true s'il reste du travail
+bool bench_step(BenchGame_t& _g, int _mode, int _max_depth, uint64_t _budget) {
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  bool more;
+  if(_mode == MODE_DEPTH) {
+    more = _g.search->step(_g.board, _g.white, _g.depth, _g.res) && ++_g.depth <= _max_depth;
+    if(!more) _g.search->finish(_g.board, _g.white, _g.res);
+  } else if(_mode == MODE_NODES) {
+    more = _g.task->step(_budget);
+  } else {
+    more = _g.mcts->step(_budget);
+  }
+  _g.steps_us.push_back(float(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now()-t0).count()));
+  return more;
+}
+
+// _nb parties lancées ensemble sur _threads threads, un pas par tranche
+void bench_interleave(const std::vector<Board64_t>& _positions, int _nb, int _threads, int _depth,
+                      int _mode, uint64_t _budget, uint64_t _mcts_iter) {
+  std::vector<BenchGame_t> games(_nb);
+  for(int i = 0; i < _nb; i++) {
+    BenchGame_t& g = games[i];
+    g.board = _positions[i % _positions.size()];
+    g.white = true;
+    g.search = NULL;
+    g.task = NULL;
+    g.tree = NULL;
+    g.mcts = NULL;
+    g.depth = 1;
+    if(_mode == MODE_MCTS) {
+      g.tree = new Mcts64_t(size_t(8)<<20, 1+i);
+      g.mcts = new MctsTask64_t(*g.tree);
+      g.mcts->start(g.board, g.white, 0.0, _mcts_iter);
+    } else {
+      g.search = new Search64_t(14);
+      g.search->opt = SearchOptions_t::all();
+      g.search->opt.pawn_eval = true;
+      if(_mode == MODE_NODES) {
+        g.task = new AbTask64_t(*g.search);
+        g.task->start(g.board, g.white, _depth, 0.0);
+      } else {
+        g.search->begin(0.0, g.res);
+      }
+    }
+  }
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  {
+    WorkPool_t pool(_threads);
+    for(int i = 0; i < _nb; i++) {
+      BenchGame_t* g = &games[i];
+      pool.push([g, _mode, _depth, _budget]() { return bench_step(*g, _mode, _depth, _budget); });
+    }
+  } // les tâches en file sont terminées avant l'arrêt
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t0).count();
+
+  std::vector<float> all;
+  uint64_t work = 0;
+  for(int i = 0; i < _nb; i++) {
+    BenchGame_t& g = games[i];
+    all.insert(all.end(), g.steps_us.begin(), g.steps_us.end());
+    if(_mode == MODE_MCTS) work += g.tree->iterations;
+    else work += _mode == MODE_NODES ? g.task->res.nodes : g.res.nodes;
+    delete g.mcts;
+    delete g.tree;
+    delete g.task;
+    delete g.search;
+  }
+  std::sort(all.begin(), all.end());
+  const char* names[3] = {"ab depth/step", "ab nodes/step", "mcts playouts/step"};
+  char budget[32] = "";
+  if(_mode != MODE_DEPTH) snprintf(budget, sizeof(budget), "%" PRIu64, _budget);
+  printf("%-19s %7s %9zu %9.0f %9.0f %9.0f %11.0f %9.0f\n", names[_mode], budget, all.size(),
+         all[all.size()/2], all[all.size()*99/100], all.back(), work*1000.0/ms, ms);
+  fflush(stdout);
+}
+
+int main(int _ac, char** _av) {
+  int nb = _ac > 1 ? atoi(_av[1]) : 200;
+  int threads = _ac > 2 ? atoi(_av[2]) : int(std::thread::hardware_concurrency());
+  if(threads < 1) threads = 1;
+  int depth = _ac > 3 ? atoi(_av[3]) : 8;
+  uint64_t nodes = _ac > 4 ? uint64_t(atoll(_av[4])) : 2000;
+  uint64_t playouts = _ac > 5 ? uint64_t(atoll(_av[5])) : 64;
+
+  std::vector<Board64_t> positions = bench_positions(8);
+  printf("resumable alpha-beta vs Search64_t::think, depth %d on %d positions\n", depth-2, (int)positions.size());
+  int errors = check_task(positions, depth-2);
+
+  const uint64_t mcts_iter = 20000;
+  printf("\n%d games interleaved on %d threads, depth %d, mcts %" PRIu64 " playouts per game\n",
+         nb, threads, depth, mcts_iter);
+  printf("%-19s %7s %9s %9s %9s %9s %11s %9s\n", "mode", "budget", "steps", "p50 us", "p99 us", "max us",
+         "work/s", "ms");
+  bench_interleave(positions, nb, threads, depth, MODE_DEPTH, 0, 0);
+  bench_interleave(positions, nb, threads, depth, MODE_NODES, nodes, 0);
+  bench_interleave(positions, nb, threads, depth, MODE_NODES, nodes*10, 0);
+  bench_interleave(positions, nb, threads, depth, MODE_MCTS, playouts, mcts_iter);
+  return errors ? 1 : 0;
+}